@@ -30,11 +30,18 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include <cfloat>
 #include <charconv>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <future>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <system_error>
@@ -46,9 +53,18 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #ifdef __linux__
 
 #include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
+
 #elif _WIN32
 
 #define WIN32_LEAN_AND_MEAN
@@ -59,14 +75,27 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 
 #include <windows.h>
 
+#include <psapi.h>
+
 #elif __APPLE__
 
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
 #define RAPIDOBJ_VERSION_MAJOR 1
 #define RAPIDOBJ_VERSION_MINOR 1
 #define RAPIDOBJ_VERSION_PATCH 0
@@ -122,6 +151,21 @@ struct MaterialLibrary final {
     std::optional<Load> m_policy{};
 };
 
+// Source of the memory that Result arrays are allocated from (an arena, a pool of pinned or huge pages, etc.). Both
+// functions may be called from several threads at once, and the resource must outlive the arrays allocated from it.
+// Allocate must return memory aligned to alignment, or throw; it must not return nullptr.
+class MemoryResource {
+  public:
+    virtual ~MemoryResource() = default;
+
+    virtual void* Allocate(std::size_t bytes, std::size_t alignment)                   = 0;
+    virtual void  Deallocate(void* pointer, std::size_t bytes, std::size_t alignment) = 0;
+};
+
+namespace detail {
+struct ArrayAccess;
+} // namespace detail
+
 template <typename T>
 class Array final {
   public:
@@ -136,18 +180,19 @@ class Array final {
     using const_iterator  = const_pointer;
 
     Array() noexcept {}
-    Array(size_type size) : m_state{ size ? std::unique_ptr<T[]>(new T[size]) : nullptr, size } {}
+    Array(size_type size, MemoryResource* resource = nullptr) : m_state{ Allocate(size, resource), size, resource } {}
 
     template <typename Iter>
-    Array(Iter begin, Iter end)
+    Array(Iter begin, Iter end, MemoryResource* resource = nullptr)
     {
         static_assert(std::is_same_v<std::random_access_iterator_tag, typename Iter::iterator_category>);
         static_assert(std::is_same_v<value_type, typename Iter::value_type>);
 
         const auto size = static_cast<size_type>(end - begin);
-        m_state.data.reset(new value_type[size]);
-        memcpy(&*begin, m_state.data.get(), size * sizeof(value_type));
-        m_state.size = size;
+        m_state         = { Allocate(size, resource), size, resource };
+        if (size) {
+            memcpy(m_state.data, &*begin, size * sizeof(value_type));
+        }
     }
 
     Array(const Array&)            = delete;
@@ -157,35 +202,65 @@ class Array final {
     Array& operator=(Array&& other) noexcept
     {
         if (this != &other) {
+            Deallocate(m_state);
             m_state = std::exchange(other.m_state, {});
         }
         return *this;
     }
 
+    ~Array() noexcept { Deallocate(m_state); }
+
     constexpr reference       operator[](size_type index) noexcept { return m_state.data[index]; }
     constexpr const_reference operator[](size_type index) const noexcept { return m_state.data[index]; }
     constexpr reference       front() noexcept { return m_state.data[0]; }
     constexpr const_reference front() const noexcept { return m_state.data[0]; }
     constexpr reference       back() noexcept { return m_state.data[m_state.size - 1]; }
     constexpr const_reference back() const noexcept { return m_state.data[m_state.size - 1]; }
-    constexpr pointer         data() noexcept { return m_state.data.get(); }
-    constexpr const_pointer   data() const noexcept { return m_state.data.get(); }
-    constexpr iterator        begin() noexcept { return m_state.data.get(); }
-    constexpr const_iterator  begin() const noexcept { return m_state.data.get(); }
-    constexpr const_iterator  cbegin() const noexcept { return m_state.data.get(); }
-    constexpr iterator        end() noexcept { return m_state.data.get() + m_state.size; }
-    constexpr const_iterator  end() const noexcept { return m_state.data.get() + m_state.size; }
-    constexpr const_iterator  cend() const noexcept { return m_state.data.get() + m_state.size; }
+    constexpr pointer         data() noexcept { return m_state.data; }
+    constexpr const_pointer   data() const noexcept { return m_state.data; }
+    constexpr iterator        begin() noexcept { return m_state.data; }
+    constexpr const_iterator  begin() const noexcept { return m_state.data; }
+    constexpr const_iterator  cbegin() const noexcept { return m_state.data; }
+    constexpr iterator        end() noexcept { return m_state.data + m_state.size; }
+    constexpr const_iterator  end() const noexcept { return m_state.data + m_state.size; }
+    constexpr const_iterator  cend() const noexcept { return m_state.data + m_state.size; }
     constexpr bool            empty() const noexcept { return m_state.size == 0; }
     constexpr size_type       size() const noexcept { return m_state.size; }
-    void                      swap(Array& other) noexcept { std::swap(m_state.state, other.m_state.state); }
+    constexpr MemoryResource* resource() const noexcept { return m_state.resource; }
+    void                      swap(Array& other) noexcept { std::swap(m_state, other.m_state); }
 
   private:
-    struct final {
-        std::unique_ptr<T[]> data;
-        size_type            size;
+    friend struct detail::ArrayAccess;
+
+    // Takes ownership of data, which must have been allocated from resource.
+    Array(pointer data, size_type size, MemoryResource* resource) noexcept : m_state{ data, size, resource } {}
+
+    struct State final {
+        pointer         data;
+        size_type       size;
+        MemoryResource* resource; // nullptr: data was allocated with new[]
     } m_state{};
 
+    static pointer Allocate(size_type size, MemoryResource* resource)
+    {
+        if (size == 0) {
+            return nullptr;
+        }
+        if (resource) {
+            return static_cast<pointer>(resource->Allocate(size * sizeof(value_type), alignof(value_type)));
+        }
+        return new value_type[size];
+    }
+
+    static void Deallocate(const State& state) noexcept
+    {
+        if (state.data && state.resource) {
+            state.resource->Deallocate(state.data, state.size * sizeof(value_type), alignof(value_type));
+        } else {
+            delete[] state.data;
+        }
+    }
+
     static_assert(
         std::is_trivially_constructible_v<value_type> && std::is_trivially_destructible_v<value_type> &&
         std::is_trivially_copyable_v<value_type>);
@@ -336,13 +411,356 @@ struct [[nodiscard]] Result final {
     Error      error;
 };
 
+// What ScanFile finds in an .obj file: the number of statements of each kind, the first material library and, if
+// requested, the bounds of the positions. Lines are classified by their keyword only; their contents are not checked.
+struct [[nodiscard]] ScanResult final {
+    size_t num_positions{}; // 'v'
+    size_t num_texcoords{}; // 'vt'
+    size_t num_normals{};   // 'vn'
+    size_t num_faces{};     // 'f'
+    size_t num_lines{};     // 'l'
+    size_t num_points{};    // 'p'
+    size_t num_shapes{};    // 'g' and 'o'
+
+    std::string material_library{}; // given on the first mtllib line (empty: none)
+
+    std::array<float, 3> min{}; // bounds of the positions (all zero if not requested, or there are no positions)
+    std::array<float, 3> max{};
+
+    Error error;
+};
+
+// The face corners of a Result, with each distinct combination of position, texcoord and normal indices stored once,
+// as returned by WeldVertices.
+struct [[nodiscard]] WeldedResult final {
+    Array<Index>    vertices; // distinct index combinations, in order of first use
+    Array<uint32_t> indices;  // position in vertices of each face corner; the meshes of all shapes, in order
+    Error           error;
+};
+
+// A non-owning view of a contiguous sequence of elements (std::span is not available in C++17).
+template <typename T>
+class Span final {
+  public:
+    using element_type    = T;
+    using value_type      = std::remove_cv_t<T>;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = element_type&;
+    using pointer         = element_type*;
+    using iterator        = pointer;
+
+    constexpr Span() noexcept {}
+    constexpr Span(pointer data, size_type size) noexcept : m_data(data), m_size(size) {}
+
+    constexpr reference operator[](size_type index) const noexcept { return m_data[index]; }
+    constexpr reference front() const noexcept { return m_data[0]; }
+    constexpr reference back() const noexcept { return m_data[m_size - 1]; }
+    constexpr pointer   data() const noexcept { return m_data; }
+    constexpr iterator  begin() const noexcept { return m_data; }
+    constexpr iterator  end() const noexcept { return m_data + m_size; }
+    constexpr bool      empty() const noexcept { return m_size == 0; }
+    constexpr size_type size() const noexcept { return m_size; }
+
+  private:
+    pointer   m_data{};
+    size_type m_size{};
+};
+
+// An array that is split into several contiguous segments.
+template <typename T>
+using Segments = std::vector<Span<const T>>;
+
+struct SegmentedAttributes final {
+    Segments<float> positions; // 'v'  (xyz)
+    Segments<float> texcoords; // 'vt' (uv)
+    Segments<float> normals;   // 'vn' (xyz)
+    Segments<float> colors;    //  vertex color extension
+};
+
+struct SegmentedMesh final {
+    Segments<Index>   indices;             // Position/Texture/Normal indices
+    Segments<uint8_t> num_face_vertices;   // Number of vertices per face
+    Array<int32_t>    material_ids;        // Material ID per face
+    Array<uint32_t>   smoothing_group_ids; // Smoothing group ID per face (group id 0 means off)
+};
+
+struct SegmentedLines final {
+    Segments<Index>   indices;           // Polyline indices
+    Segments<int32_t> num_line_vertices; // Number of vertices per polyline
+};
+
+struct SegmentedPoints final {
+    Segments<Index> indices; // Points indices
+};
+
+struct SegmentedShape final {
+    std::string     name;
+    SegmentedMesh   mesh;
+    SegmentedLines  lines;
+    SegmentedPoints points;
+};
+
+using SegmentedShapes = std::vector<SegmentedShape>;
+
+// Same contents as Result, but attributes and indices are not merged into single arrays; the segments point directly
+// into the buffers filled by the parser, which are kept alive by storage.
+struct [[nodiscard]] SegmentedResult final {
+    SegmentedAttributes   attributes;
+    SegmentedShapes       shapes;
+    Materials             materials;
+    Error                 error;
+    std::shared_ptr<void> storage{};
+};
+
+namespace detail {
+struct ThreadPoolAccess;
+} // namespace detail
+
+// A pool of worker threads that can be reused across ParseFile, ParseStream and Triangulate calls. Each worker owns a
+// task queue; idle workers steal tasks from the other queues, and threads waiting for their tasks to finish help
+// run pending tasks in the meantime (so the same pool can be shared by several application threads).
+class ThreadPool final {
+  public:
+    // If cpu_affinity is not empty, the worker threads are pinned to the listed CPUs.
+    explicit ThreadPool(
+        size_t              num_threads  = std::thread::hardware_concurrency(),
+        std::vector<size_t> cpu_affinity = {})
+        : m_cpu_affinity(std::move(cpu_affinity))
+    {
+        num_threads = std::max(num_threads, size_t(1));
+
+        m_queues.reserve(num_threads);
+        m_threads.reserve(num_threads);
+
+        for (size_t i = 0; i != num_threads; ++i) {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i != num_threads; ++i) {
+            m_threads.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&)                 = delete;
+    ThreadPool& operator=(ThreadPool&&)      = delete;
+    ~ThreadPool() noexcept
+    {
+        {
+            auto lock = std::lock_guard(m_mutex);
+            m_stop    = true;
+        }
+        m_wakeup.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    size_t Size() const noexcept { return m_threads.size(); }
+
+  private:
+    friend struct detail::ThreadPoolAccess;
+
+    using Task = std::function<void()>;
+
+    struct Queue final {
+        std::mutex       mutex{};
+        std::deque<Task> tasks{};
+    };
+
+    struct Worker final {
+        const ThreadPool* pool{};
+        size_t            index{};
+    };
+
+    static Worker& CurrentWorker() noexcept
+    {
+        thread_local auto worker = Worker{};
+        return worker;
+    }
+
+    void Submit(Task task)
+    {
+        // tasks submitted by a worker go to its own queue; others are distributed round-robin
+        auto& worker = CurrentWorker();
+        auto  index  = worker.pool == this ? worker.index : m_next++ % m_queues.size();
+        {
+            // count the task before it becomes visible, so that m_pending never drops below zero
+            auto lock = std::lock_guard(m_mutex);
+            ++m_pending;
+        }
+        {
+            auto lock = std::lock_guard(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        m_wakeup.notify_one();
+    }
+
+    // Runs one pending task: a worker takes the newest task from its own queue, or else steals the oldest task
+    // from another queue. Returns false if there are no pending tasks.
+    bool RunPendingTask()
+    {
+        auto& worker = CurrentWorker();
+        bool  owned  = worker.pool == this;
+        auto  first  = owned ? worker.index : m_next.load() % m_queues.size();
+        auto  task   = Task();
+
+        for (size_t i = 0; i != m_queues.size() && !task; ++i) {
+            auto& queue = *m_queues[(first + i) % m_queues.size()];
+            auto  lock  = std::lock_guard(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (owned && i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --m_pending;
+        }
+
+        if (!task) {
+            return false;
+        }
+
+        task();
+
+        return true;
+    }
+
+    void WorkerLoop(size_t index);
+
+    std::vector<size_t>                 m_cpu_affinity{};
+    std::vector<std::unique_ptr<Queue>> m_queues{};
+    std::vector<std::thread>            m_threads{};
+    std::atomic_size_t                  m_next{};    // next queue for tasks submitted by non-workers
+    std::atomic_size_t                  m_pending{}; // number of queued tasks
+    bool                                m_stop{};
+    std::mutex                          m_mutex{}; // protects m_stop; m_pending is incremented under it
+    std::condition_variable             m_wakeup{};
+};
+
+namespace detail {
+struct ParserState;
+struct ParserContextAccess;
+} // namespace detail
+
+// Keeps the buffers that ParseFile and ParseStream allocate while parsing, so that later calls that are given the same
+// context reuse them instead of allocating (and page faulting) them again. A context serves one call at a time; a call
+// that finds the context in use by another call allocates its own buffers.
+class ParserContext final {
+  public:
+    ParserContext();
+    ParserContext(const ParserContext&)            = delete;
+    ParserContext& operator=(const ParserContext&) = delete;
+    ParserContext(ParserContext&&)                 = delete;
+    ParserContext& operator=(ParserContext&&)      = delete;
+    ~ParserContext() noexcept;
+
+    // Number of bytes of memory held by the retained buffers.
+    size_t Capacity() const;
+
+    // Frees the retained buffers.
+    void Clear();
+
+  private:
+    friend struct detail::ParserContextAccess;
+
+    std::unique_ptr<detail::ParserState> m_state;
+};
+
+enum class Read { Standard, IoUring, MemoryMap };
+
+struct Options final {
+    Read   read        = Read::Standard; // method used to read .obj file (falls back to Standard if unavailable)
+    size_t queue_depth = 4;              // number of blocks kept in flight per thread (Read::IoUring only)
+    bool   populate    = false;          // pre-fault the whole file mapping up front (Read::MemoryMap only)
+    bool   direct_io   = false;          // bypass the OS page cache (Read::Standard and Read::IoUring only)
+    bool   presize     = false;          // size parse buffers up front, from the contents of the first block read
+    bool   huge_pages  = false;          // back large parse buffers and Result arrays with huge pages
+
+    bool skip_texcoords = false; // do not load texcoords; texcoord indices are set to -1
+    bool skip_normals   = false; // do not load normals; normal indices are set to -1
+    bool skip_colors    = false; // do not load vertex colors
+
+    ThreadPool*         thread_pool  = nullptr; // run parallel work on this pool, instead of on newly spawned threads
+    size_t              max_threads  = 0;       // maximum number of threads used for parallel work (0: no limit)
+    std::vector<size_t> cpu_affinity = {};      // pin newly spawned threads to these CPUs (empty: do not pin)
+
+    MemoryResource* memory_resource = nullptr; // allocate Result arrays from this resource (nullptr: use new[])
+    ParserContext*  parser_context  = nullptr; // reuse the buffers retained by this context (nullptr: allocate them)
+
+    std::filesystem::path cache_directory = {}; // load and save results here, keyed by file contents (empty: no cache)
+
+    std::function<bool(std::string_view name)> shape_filter = {}; // load only the shapes it accepts (empty: all)
+};
+
+// Receives the elements of an .obj file as VisitFile parses them, without a Result being built. The file is split into
+// chunks of whole lines that are parsed in parallel; each chunk has its own visitor, which is called from one thread
+// only and sees the lines of its chunk in file order. Indices are passed as they appear in the file: positive indices
+// count from 1, negative indices count back from the last attribute defined before the element (-1 is the last one),
+// and 0 means that a texcoord or normal index is not present. Indices are not checked against the attribute counts.
+class Visitor {
+  public:
+    virtual ~Visitor() = default;
+
+    virtual void Position(float, float, float) {}
+    virtual void Color(float, float, float) {} // follows Position, if the vertex has a color
+    virtual void Texcoord(float, float) {}
+    virtual void Normal(float, float, float) {}
+    virtual void Face(const Index*, size_t) {}
+    virtual void Line(const Index*, size_t) {}
+    virtual void Point(const Index*, size_t) {}
+    virtual void Group(std::string_view) {}        // g and o statements
+    virtual void UseMaterial(std::string_view) {}  // usemtl statements
+    virtual void MaterialFile(std::string_view) {} // mtllib statements
+    virtual void SmoothingGroup(unsigned int) {}   // s statements; 0 is off
+};
+
 inline Result ParseFile(
     const std::filesystem::path& obj_filepath,
-    const MaterialLibrary&       mtl_library = MaterialLibrary::Default());
+    const MaterialLibrary&       mtl_library = MaterialLibrary::Default(),
+    const Options&               options     = Options());
+
+inline std::vector<Result> ParseFiles(
+    const std::vector<std::filesystem::path>& obj_filepaths,
+    const MaterialLibrary&                    mtl_library = MaterialLibrary::Default(),
+    const Options&                            options     = Options());
+
+inline Result ParseStream(
+    std::istream&          obj_stream,
+    const MaterialLibrary& mtl_library = MaterialLibrary::Default(),
+    const Options&         options     = Options());
+
+inline SegmentedResult ParseFileSegmented(
+    const std::filesystem::path& obj_filepath,
+    const MaterialLibrary&       mtl_library = MaterialLibrary::Default(),
+    const Options&               options     = Options());
+
+inline SegmentedResult ParseStreamSegmented(
+    std::istream&          obj_stream,
+    const MaterialLibrary& mtl_library = MaterialLibrary::Default(),
+    const Options&         options     = Options());
+
+inline bool Triangulate(Result& result, const Options& options = Options());
+
+inline WeldedResult WeldVertices(const Result& result, const Options& options = Options());
 
-inline Result ParseStream(std::istream& obj_stream, const MaterialLibrary& mtl_library = MaterialLibrary::Default());
+inline void FlushDeferredFrees();
 
-inline bool Triangulate(Result& result);
+inline std::error_code SaveBinary(const Result& result, const std::filesystem::path& filepath);
+
+inline Result LoadBinary(const std::filesystem::path& filepath);
+
+inline Error VisitFile(
+    const std::filesystem::path&                       obj_filepath,
+    const std::function<Visitor*(size_t chunk_index)>& make_visitor,
+    const Options&                                     options = Options());
+
+inline ScanResult
+ScanFile(const std::filesystem::path& obj_filepath, bool compute_bounds = false, const Options& options = Options());
 
 } // namespace rapidobj
 
@@ -4142,6 +4560,7 @@ enum class rapidobj_errc {
     TooFewIndicesError,
     TooManyIndicesError,
     TriangulationError,
+    BinaryFormatError,
     InternalError
 };
 } // namespace rapidobj
@@ -4171,6 +4590,7 @@ struct rapidobj_error_category : std::error_category {
         case rapidobj_errc::TooFewIndicesError: return "Polygon has too few indices.";
         case rapidobj_errc::TooManyIndicesError: return "Polygon has too many indices.";
         case rapidobj_errc::TriangulationError: return "Triangulation errror.";
+        case rapidobj_errc::BinaryFormatError: return "Binary file is invalid or has an unsupported version.";
         case rapidobj_errc::InternalError: return "Internal error.";
         }
         return "Unrecognised error.";
@@ -4209,6 +4629,9 @@ static constexpr auto kMaxVerticesInLine  = 1000;
 static constexpr auto kMinVerticesInPoint = 1;
 static constexpr auto kMaxVerticesInPoint = 1000;
 static constexpr auto kSingleThreadCutoff = 1_MiB;
+static constexpr auto kMaxQueueDepth      = size_t(32);
+static constexpr auto kStreamBatchSize    = 1_MiB;
+static constexpr auto kInvalidIndex       = std::numeric_limits<int>::min(); // fails the merge step bounds check
 
 static constexpr auto kMergeCopyByteCost  = 12;
 static constexpr auto kMergeCopyIntCost   = 31;
@@ -4221,7 +4644,21 @@ static constexpr auto kTriangulateQuadCost      = 140;
 static constexpr auto kTriangulatePerIndexCost  = 46;
 static constexpr auto kTriangulateSubdivideCost = 5000000;
 
+static constexpr auto kWeldBlockSize  = size_t(64 * 1024); // face corners per task
+static constexpr auto kWeldPartitions = size_t(256);       // hash table partitions, when welding on several threads
+
 static constexpr auto kMemoryRecyclingSize = 25_MiB;
+static constexpr auto kMaxDeferredFrees    = size_t(8);
+
+static constexpr auto kBinaryVersion   = uint32_t(1);
+static constexpr auto kBinaryByteOrder = uint32_t(0x01020304); // reads as 0x04030201 on a host of the other byte order
+static constexpr auto kBinaryAlignment = size_t(64);
+static constexpr auto kHashBlockSize   = 1_MiB;
+
+static constexpr char kBinaryMagic[8] = { 'R', 'A', 'P', 'I', 'D', 'O', 'B', 'J' };
+
+static constexpr auto kHugePageSize          = 2_MiB;
+static constexpr auto kMinHugePageAllocation = 4_MiB; // smaller allocations would waste too much of their last page
 
 static_assert(kMaxLineLength < kBlockSize);
 static_assert(kBlockSize % 4_KiB == 0);
@@ -4318,11 +4755,54 @@ struct Buffer final {
     Buffer() noexcept = default;
     Buffer(size_t size) noexcept : m_size(size), m_room(0), m_data(new T[size]) {}
 
+    Buffer(const Buffer&)            = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    Buffer(Buffer&& other) noexcept { *this = std::move(other); }
+    Buffer& operator=(Buffer&& other) noexcept
+    {
+        if (this != &other) {
+            deallocate();
+            m_size              = std::exchange(other.m_size, 0);
+            m_room              = std::exchange(other.m_room, 0);
+            m_data              = std::exchange(other.m_data, nullptr);
+            m_resource          = std::exchange(other.m_resource, nullptr);
+            m_num_reallocations = std::exchange(other.m_num_reallocations, 0);
+            m_num_bytes_copied  = std::exchange(other.m_num_bytes_copied, 0);
+        }
+        return *this;
+    }
+
+    ~Buffer() noexcept { deallocate(); }
+
     size_t   size() const noexcept { return m_size; }
-    const T* data() const noexcept { return m_data.get(); }
-    T*       data() noexcept { return m_data.get(); }
+    size_t   capacity() const noexcept { return m_size + m_room; }
+    const T* data() const noexcept { return m_data; }
+    T*       data() noexcept { return m_data; }
     T&       back() noexcept { return m_data[m_size - 1]; }
 
+    // Empties the buffer, but keeps its memory.
+    void clear() noexcept
+    {
+        m_room += m_size;
+        m_size              = 0;
+        m_num_reallocations = 0;
+        m_num_bytes_copied  = 0;
+    }
+
+    // Memory is allocated from the resource from now on (nullptr: new[]); memory that was allocated from a different
+    // resource is freed.
+    void set_resource(MemoryResource* resource) noexcept
+    {
+        if (resource != m_resource) {
+            deallocate();
+            m_size     = 0;
+            m_room     = 0;
+            m_data     = nullptr;
+            m_resource = resource;
+        }
+    }
+
     void push_back(T value) noexcept
     {
         m_data[m_size] = value;
@@ -4332,12 +4812,12 @@ struct Buffer final {
     T pop_back() noexcept
     {
         --m_size, ++m_room;
-        return m_data.get()[m_size];
+        return m_data[m_size];
     }
 
     void fill_n(size_t n, T value)
     {
-        std::fill_n(m_data.get() + m_size, n, value);
+        std::fill_n(m_data + m_size, n, value);
         m_size += n;
         m_room -= n;
     }
@@ -4345,22 +4825,54 @@ struct Buffer final {
     void ensure_enough_room_for(size_t size)
     {
         if (size > m_room) {
-            auto cap = std::max(kInitialSize, 2 * (m_size + size));
-            auto src = std::unique_ptr<T[]>(std::move(m_data));
-            m_data.reset(new T[cap]);
-            if (src) {
-                memcpy(m_data.get(), src.get(), m_size * sizeof(T));
-            }
-            m_room = cap - m_size;
+            reallocate(std::max(kInitialSize, 2 * (m_size + size)));
+        }
+    }
+
+    // Unlike ensure_enough_room_for, allocates exactly the requested capacity.
+    void reserve(size_t capacity)
+    {
+        if (capacity > m_size + m_room) {
+            reallocate(capacity);
         }
     }
 
+    size_t num_reallocations() const noexcept { return m_num_reallocations; }
+    size_t num_bytes_copied() const noexcept { return m_num_bytes_copied; }
+
   private:
+    void reallocate(size_t cap)
+    {
+        auto src = m_data;
+        m_data   = m_resource ? static_cast<T*>(m_resource->Allocate(cap * sizeof(T), alignof(T))) : new T[cap];
+        if (src) {
+            memcpy(m_data, src, m_size * sizeof(T));
+            ++m_num_reallocations;
+            m_num_bytes_copied += m_size * sizeof(T);
+            deallocate(src, m_size + m_room);
+        }
+        m_room = cap - m_size;
+    }
+
+    void deallocate(T* data, size_t capacity) noexcept
+    {
+        if (data && m_resource) {
+            m_resource->Deallocate(data, capacity * sizeof(T), alignof(T));
+        } else {
+            delete[] data;
+        }
+    }
+
+    void deallocate() noexcept { deallocate(m_data, m_size + m_room); }
+
     static constexpr size_t kInitialSize = 4096;
 
-    size_t               m_size{};
-    size_t               m_room{};
-    std::unique_ptr<T[]> m_data{};
+    size_t          m_size{};
+    size_t          m_room{};
+    T*              m_data{};
+    MemoryResource* m_resource{}; // nullptr: m_data was allocated with new[]
+    size_t          m_num_reallocations{};
+    size_t          m_num_bytes_copied{};
 
     static_assert(std::is_trivially_copyable_v<T>);
 };
@@ -4382,6 +4894,7 @@ struct ShapeRecord final {
     Lines       lines{};
     Points      points{};
     size_t      chunk_index{};
+    bool        skipped{}; // rejected by the shape filter
 };
 
 struct MaterialRecord final {
@@ -4404,11 +4917,27 @@ struct SmoothingRecord final {
     size_t       face_buffer_start{};
 };
 
+struct ThreadPoolAccess final {
+    static void Submit(ThreadPool* pool, std::function<void()> task) { pool->Submit(std::move(task)); }
+    static bool RunPendingTask(ThreadPool* pool) { return pool->RunPendingTask(); }
+};
+
+struct Chunk;
+
 struct SharedContext final {
     struct Thread final {
-        size_t concurrency{};
+        size_t              concurrency{};
+        ThreadPool*         pool{};         // nullptr: spawn new threads
+        size_t              max_threads{};  // 0: no limit
+        std::vector<size_t> cpu_affinity{}; // CPUs that newly spawned threads are pinned to
     } thread;
 
+    struct Io final {
+        Read             read{};
+        size_t           queue_depth{};
+        std::string_view mapping{}; // file contents (Read::MemoryMap only)
+    } io;
+
     struct Stats final {
         size_t num_positions{};
         size_t num_texcoords{};
@@ -4426,6 +4955,16 @@ struct SharedContext final {
     struct Parsing final {
         std::atomic_size_t thread_count{};
         std::promise<void> completed{};
+        bool               presize{};  // estimate buffer sizes before parsing (ParseFile only)
+        MemoryResource*    resource{}; // allocates chunk buffers (nullptr: new[])
+        ParserState*       retained{}; // buffers kept from earlier calls by a ParserContext (nullptr: none)
+
+        const std::function<void(size_t, Chunk*)>*   prepare_chunk{}; // sets up each chunk (VisitFile and ScanFile)
+        const std::function<bool(std::string_view)>* shape_filter{};  // selects the shapes to load (nullptr: all)
+
+        bool skip_texcoords{}; // vt lines are only counted, and texcoord indices are dropped
+        bool skip_normals{};   // vn lines are only counted, and normal indices are dropped
+        bool skip_colors{};    // v lines are not checked for vertex colors
     } parsing;
 
     struct Merging final {
@@ -4433,11 +4972,13 @@ struct SharedContext final {
         std::atomic_size_t thread_count{};
         std::promise<void> completed{};
         rapidobj_errc      error{};
-        std::mutex         mutex{}; // protects error
+        std::mutex         mutex{};    // protects error
+        MemoryResource*    resource{}; // allocates Result arrays (nullptr: new[])
     } merging;
 
     struct Debug final {
         struct IO final {
+            std::vector<const char*>              reader{};
             std::vector<int>                      num_requests{};
             std::vector<size_t>                   num_bytes_read{};
             std::vector<std::chrono::nanoseconds> submit_time;
@@ -4446,13 +4987,23 @@ struct SharedContext final {
         struct Parse final {
             std::vector<std::chrono::nanoseconds> time;
             std::chrono::nanoseconds              total_time;
+            size_t                                num_reallocations; // buffers that had to grow while parsing
+            size_t                                num_bytes_copied;  // bytes moved by those reallocations
+            size_t                                num_page_faults;   // incurred by the whole process while parsing
         } parse;
         struct Merge final {
             std::chrono::nanoseconds total_time;
+            size_t                   num_page_faults; // incurred by the whole process while merging
         } merge;
     } debug;
 };
 
+// The part of a ScanResult that is found in one chunk.
+struct ChunkScan final {
+    ScanResult result{};
+    bool       bounds{}; // the min and max of the positions are tracked
+};
+
 struct Chunk final {
     struct Text final {
         size_t line_count{};
@@ -4521,8 +5072,76 @@ struct Chunk final {
     Materials materials;
     Smoothing smoothing;
     Error     error;
+
+    // No other chunk precedes this one, so relative indices can be resolved to their final values during parsing,
+    // instead of being rebased in the merge step.
+    bool is_first{};
+
+    // Receives the parsed elements instead of the buffers (VisitFile only).
+    Visitor* visitor{};
+
+    // Counts the lines instead of parsing them (ScanFile only).
+    ChunkScan* scan{};
+
+    // The current shape was rejected by the shape filter, so its faces, lines and points are not stored. A chunk does
+    // not know which shape it starts in, so the elements before its first shape record are always stored.
+    bool skip_elements{};
 };
 
+// Calls function on each buffer of the chunk.
+template <typename ChunkType, typename Function>
+void ForEachBuffer(ChunkType& chunk, Function&& function)
+{
+    function(chunk.positions.buffer);
+    function(chunk.texcoords.buffer);
+    function(chunk.normals.buffer);
+    function(chunk.colors.buffer);
+    function(chunk.mesh.indices.buffer);
+    function(chunk.mesh.indices.flags);
+    function(chunk.mesh.faces.buffer);
+    function(chunk.lines.indices.buffer);
+    function(chunk.lines.indices.flags);
+    function(chunk.lines.segments.buffer);
+    function(chunk.points.indices.buffer);
+    function(chunk.points.indices.flags);
+}
+
+// Empties a chunk (which may be left over from an earlier call) before it is parsed into. Buffers keep their memory,
+// unless it was allocated from a different resource.
+inline void ResetChunk(Chunk* chunk, MemoryResource* resource) noexcept
+{
+    ForEachBuffer(*chunk, [resource](auto& buffer) {
+        buffer.set_resource(resource);
+        buffer.clear();
+    });
+
+    chunk->text.line_count      = 0;
+    chunk->positions.count      = 0;
+    chunk->texcoords.count      = 0;
+    chunk->normals.count        = 0;
+    chunk->colors.count         = 0;
+    chunk->mesh.faces.count     = 0;
+    chunk->lines.segments.count = 0;
+    chunk->error                = Error{};
+    chunk->is_first             = false;
+    chunk->visitor              = nullptr;
+    chunk->scan                 = nullptr;
+    chunk->skip_elements        = false;
+
+    chunk->shapes.list.clear();
+    chunk->materials.list.clear();
+    chunk->smoothing.list.clear();
+}
+
+inline size_t CapacityInBytes(const Chunk& chunk) noexcept
+{
+    auto size = size_t{ 0 };
+    ForEachBuffer(chunk, [&size](const auto& buffer) {
+        size += buffer.capacity() * sizeof(*buffer.data());
+    });
+    return size;
+}
+
 inline size_t SizeInBytes(const Chunk& chunk) noexcept
 {
     auto size = size_t{ 0 };
@@ -4543,6 +5162,33 @@ inline size_t SizeInBytes(const Chunk& chunk) noexcept
     return size;
 }
 
+// Adds up how many times the buffers of the chunk had to grow while it was parsed.
+inline std::pair<size_t, size_t> CountReallocations(const Chunk& chunk) noexcept
+{
+    auto num_reallocations = size_t{ 0 };
+    auto num_bytes_copied  = size_t{ 0 };
+
+    auto add = [&](const auto& buffer) {
+        num_reallocations += buffer.num_reallocations();
+        num_bytes_copied += buffer.num_bytes_copied();
+    };
+
+    add(chunk.positions.buffer);
+    add(chunk.texcoords.buffer);
+    add(chunk.normals.buffer);
+    add(chunk.colors.buffer);
+    add(chunk.mesh.indices.buffer);
+    add(chunk.mesh.indices.flags);
+    add(chunk.mesh.faces.buffer);
+    add(chunk.lines.indices.buffer);
+    add(chunk.lines.indices.flags);
+    add(chunk.lines.segments.buffer);
+    add(chunk.points.indices.buffer);
+    add(chunk.points.indices.flags);
+
+    return { num_reallocations, num_bytes_copied };
+}
+
 inline size_t SizeInBytes(const Mesh& mesh) noexcept
 {
     auto size = size_t{ 0 };
@@ -4689,6 +5335,12 @@ struct FillIds final {
     size_t                         m_start{};
 };
 
+// Offset flags starting at the given index, or nullptr if none of the indices in the buffer is relative.
+inline const OffsetFlags* OffsetFlagsAt(const Buffer<OffsetFlags>& flags, size_t start) noexcept
+{
+    return flags.size() ? flags.data() + start : nullptr;
+}
+
 struct CopyIndices final {
     CopyIndices(
         Index*             dst,
@@ -4704,6 +5356,10 @@ struct CopyIndices final {
 
     auto Execute() const noexcept
     {
+        if (!m_offset_flags) {
+            return ExecuteWithoutOffsets();
+        }
+
         for (size_t i = 0; i != m_size; ++i) {
             auto position_index = m_src[i].position_index;
             auto texcoord_index = m_src[i].texcoord_index;
@@ -4748,6 +5404,37 @@ struct CopyIndices final {
     inline auto Subdivide(size_t num) const noexcept;
 
   private:
+    // None of the indices is relative, so this is a straight copy with a bounds check that the compiler can vectorize.
+    // When the indices are rebased in place (m_dst == m_src), only the bounds check is needed.
+    rapidobj_errc ExecuteWithoutOffsets() const noexcept
+    {
+        auto position_count = static_cast<unsigned>(m_count.position);
+        auto texcoord_count = static_cast<unsigned>(m_count.texcoord);
+        auto normal_count   = static_cast<unsigned>(m_count.normal);
+
+        // texcoord and normal indices are either -1 (not present) or in range; -1 wraps around to 0
+        auto is_out_of_bounds = [=](const Index& index) {
+            return (static_cast<unsigned>(index.position_index) >= position_count) |
+                   (static_cast<unsigned>(index.texcoord_index) + 1 > texcoord_count) |
+                   (static_cast<unsigned>(index.normal_index) + 1 > normal_count);
+        };
+
+        bool any_out_of_bounds = false;
+
+        if (m_dst == m_src) {
+            for (size_t i = 0; i != m_size; ++i) {
+                any_out_of_bounds |= is_out_of_bounds(m_src[i]);
+            }
+        } else {
+            for (size_t i = 0; i != m_size; ++i) {
+                any_out_of_bounds |= is_out_of_bounds(m_src[i]);
+                m_dst[i] = m_src[i];
+            }
+        }
+
+        return any_out_of_bounds ? rapidobj_errc::IndexOutOfBoundsError : rapidobj_errc::Success;
+    }
+
     Index*             m_dst{};
     const Index*       m_src{};
     const OffsetFlags* m_offset_flags{};
@@ -4809,7 +5496,8 @@ auto CopyIndices::Subdivide(size_t num) const noexcept
     tasks.reserve(num);
     for (size_t i = 0; i != num; ++i) {
         auto end = (1 + i) * m_size / num;
-        tasks.push_back(CopyIndices(m_dst + begin, m_src + begin, m_offset_flags, end - begin, m_offset, m_count));
+        auto offset_flags = m_offset_flags ? m_offset_flags + begin : nullptr;
+        tasks.push_back(CopyIndices(m_dst + begin, m_src + begin, offset_flags, end - begin, m_offset, m_count));
         begin = end;
     }
     return tasks;
@@ -4825,6 +5513,13 @@ struct Reader {
 
     virtual std::error_code ReadBlock(size_t offset, size_t size, char* buffer) = 0;
     virtual ReadResult      WaitForResult()                                     = 0;
+    virtual const char*     Name() const noexcept                               = 0;
+
+    // Maximum number of ReadBlock requests that may be in flight; results are returned in submission order.
+    virtual size_t QueueDepth() const noexcept { return 1; }
+
+    // Buffers passed to subsequent ReadBlock calls; readers may pre-register them with the OS.
+    virtual void RegisterBuffers(const std::vector<char*>&, size_t) noexcept {}
 
     auto NumRequests() const noexcept { return m_num_requests; }
     auto SubmitTime() const noexcept { return m_submit_time; }
@@ -4853,9 +5548,74 @@ struct AlignedDeleter final {
     void operator()(void* ptr) const { free(ptr); }
 };
 
+// Maps size bytes (a multiple of kHugePageSize) of huge pages: from the hugetlbfs pool if one is configured, or else
+// as transparent huge pages. Returns nullptr if the memory could not be mapped.
+inline void* AllocateHugePages(size_t size) noexcept
+{
+    constexpr auto protection = PROT_READ | PROT_WRITE;
+    constexpr auto flags      = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+    if (auto data = mmap(nullptr, size, protection, flags | MAP_HUGETLB, -1, 0); data != MAP_FAILED) {
+        return data;
+    }
+#endif
+
+    // over-allocate, so that the mapping can be trimmed to a huge page boundary
+    auto data = mmap(nullptr, size + kHugePageSize, protection, flags, -1, 0);
+
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(data);
+    auto head    = (kHugePageSize - address % kHugePageSize) % kHugePageSize;
+    auto aligned = static_cast<char*>(data) + head;
+
+    if (head) {
+        munmap(data, head);
+    }
+    munmap(aligned + size, kHugePageSize - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+    return aligned;
+}
+
+inline void FreeHugePages(void* data, size_t size) noexcept
+{
+    munmap(data, size);
+}
+
+// Number of page faults (minor and major) that the process has incurred so far.
+inline size_t PageFaultCount() noexcept
+{
+    auto usage = rusage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_minflt + usage.ru_majflt);
+}
+
+// Pins the calling thread to the given CPUs. Returns false if the thread could not be pinned.
+inline bool SetThreadAffinity(const std::vector<size_t>& cpus) noexcept
+{
+    auto cpu_set = cpu_set_t{};
+
+    CPU_ZERO(&cpu_set);
+
+    for (auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+
+    return CPU_COUNT(&cpu_set) > 0 && 0 == sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+}
+
 class File final {
   public:
-    File(const std::filesystem::path& filepath)
+    File(const std::filesystem::path& filepath, bool direct = false)
     {
         auto filepath_string = filepath.string();
 
@@ -4864,7 +5624,15 @@ class File final {
             return;
         }
 
-        m_fd = open(filepath_string.c_str(), O_RDONLY);
+        if (direct) {
+            m_fd     = open(filepath_string.c_str(), O_RDONLY | O_DIRECT);
+            m_direct = m_fd != -1;
+        }
+
+        // EINVAL: file system does not support O_DIRECT; use buffered reads instead
+        if (-1 == m_fd && (!direct || errno == EINVAL)) {
+            m_fd = open(filepath_string.c_str(), O_RDONLY);
+        }
 
         if (-1 == m_fd) {
             m_error = std::error_code(errno, std::system_category());
@@ -4884,16 +5652,81 @@ class File final {
     explicit operator bool() const noexcept { return m_fd != -1; }
     auto     handle() const noexcept { return m_fd; }
     auto     size() const noexcept { return static_cast<size_t>(m_info.st_size); }
+    auto     direct() const noexcept { return m_direct; }
     auto     error() const noexcept { return m_error; }
 
   private:
     int             m_fd = -1;
+    bool            m_direct{};
     struct stat     m_info {};
     std::error_code m_error{};
 };
 
+class FileMapping final {
+  public:
+    // copy_on_write: the pages may be written to; writes are private to the process and never reach the file
+    FileMapping(const File& file, bool populate, bool copy_on_write = false) noexcept
+    {
+        auto protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+        auto flags      = MAP_PRIVATE;
+
+        if (populate) {
+            flags |= MAP_POPULATE;
+        }
+
+        auto ptr = mmap(nullptr, file.size(), protection, flags, file.handle(), 0);
+
+        if (ptr == MAP_FAILED) {
+            m_error = std::error_code(errno, std::system_category());
+            return;
+        }
+
+        m_data = static_cast<const char*>(ptr);
+        m_size = file.size();
+
+        // hints only; ignore failure (a copy-on-write mapping is kept around, so its pages should not be dropped early)
+        if (!copy_on_write) {
+            madvise(ptr, m_size, MADV_SEQUENTIAL);
+        }
+        if (!populate) {
+            madvise(ptr, m_size, MADV_WILLNEED);
+        }
+    }
+    FileMapping(const FileMapping&)            = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+    FileMapping(FileMapping&&)                 = delete;
+    FileMapping& operator=(FileMapping&&)      = delete;
+    ~FileMapping() noexcept
+    {
+        if (m_data) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    explicit operator bool() const noexcept { return m_data != nullptr; }
+    auto     data() const noexcept { return m_data; }
+    auto     size() const noexcept { return m_size; }
+    auto     error() const noexcept { return m_error; }
+
+  private:
+    const char*     m_data{};
+    size_t          m_size{};
+    std::error_code m_error{};
+};
+
+// O_DIRECT requires aligned offsets and sizes; round the tail block up to a 4 KiB multiple (the read stops at EOF)
+inline size_t DirectReadSize(size_t offset, size_t size, size_t file_size) noexcept
+{
+    if (offset >= file_size) {
+        return 0;
+    }
+    auto remaining = file_size - offset;
+    return remaining < size ? std::min(size, (remaining + 4_KiB - 1) / 4_KiB * 4_KiB) : size;
+}
+
 struct FileReader : Reader {
-    FileReader(const File& file) noexcept : m_fd{ file.handle() } {}
+    FileReader(const File& file) noexcept : m_fd{ file.handle() }, m_direct{ file.direct() }, m_file_size{ file.size() }
+    {}
 
     std::error_code ReadBlock(size_t offset, size_t size, char* buffer) override
     {
@@ -4906,10 +5739,13 @@ struct FileReader : Reader {
         auto t1 = std::chrono::steady_clock::now();
 
         m_offset = offset;
-        m_size   = size;
+        m_size   = m_direct ? DirectReadSize(offset, size, m_file_size) : size;
         m_buffer = buffer;
 
-        readahead(m_fd, offset, size);
+        // readahead would populate the page cache that O_DIRECT is meant to bypass
+        if (!m_direct) {
+            readahead(m_fd, offset, size);
+        }
 
         auto t2 = std::chrono::steady_clock::now();
 
@@ -4940,13 +5776,317 @@ struct FileReader : Reader {
         return ReadResult{ bytes_read, std::error_code() };
     }
 
+    const char* Name() const noexcept override { return m_direct ? "pread (O_DIRECT)" : "pread"; }
+
   private:
     int    m_fd = -1;
+    bool   m_direct{};
+    size_t m_file_size{};
     size_t m_offset{};
     size_t m_size{};
     char*  m_buffer{};
 };
 
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+
+struct UringReader : Reader {
+    UringReader(const File& file, size_t queue_depth) noexcept
+        : m_fd{ file.handle() }, m_direct{ file.direct() }, m_file_size{ file.size() },
+          m_queue_depth{ std::clamp(queue_depth, size_t(1), kMaxQueueDepth) }
+    {
+        auto params = io_uring_params{};
+
+        m_ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(m_queue_depth), &params));
+
+        if (-1 == m_ring_fd) {
+            m_error = std::error_code(errno, std::system_category());
+            return;
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        m_sqes_size    = params.sq_entries * sizeof(io_uring_sqe);
+
+        bool single_mmap = false;
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+        single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+#endif
+
+        if (single_mmap) {
+            m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+
+        m_sq_ring = Map(m_sq_ring_size, IORING_OFF_SQ_RING);
+        m_cq_ring = single_mmap ? m_sq_ring : Map(m_cq_ring_size, IORING_OFF_CQ_RING);
+        m_sqes    = static_cast<io_uring_sqe*>(Map(m_sqes_size, IORING_OFF_SQES));
+
+        if (!m_sq_ring || !m_cq_ring || !m_sqes) {
+            m_error = std::error_code(errno, std::system_category());
+            return;
+        }
+
+        auto sq_ring = static_cast<char*>(m_sq_ring);
+        auto cq_ring = static_cast<char*>(m_cq_ring);
+
+        m_sq_tail  = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+        m_sq_mask  = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+        m_cq_head  = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+        m_cq_tail  = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+        m_cq_mask  = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+        m_cqes     = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+        // fixed file is an optimization; ignore failure
+        int fds[] = { m_fd };
+        m_fixed_file = 0 == syscall(__NR_io_uring_register, m_ring_fd, IORING_REGISTER_FILES, fds, 1);
+    }
+
+    UringReader(const UringReader&)            = delete;
+    UringReader& operator=(const UringReader&) = delete;
+    UringReader(UringReader&&)                 = delete;
+    UringReader& operator=(UringReader&&)      = delete;
+
+    ~UringReader() noexcept override
+    {
+        if (m_sqes) {
+            munmap(m_sqes, m_sqes_size);
+        }
+        if (m_cq_ring && m_cq_ring != m_sq_ring) {
+            munmap(m_cq_ring, m_cq_ring_size);
+        }
+        if (m_sq_ring) {
+            munmap(m_sq_ring, m_sq_ring_size);
+        }
+        if (m_ring_fd != -1) {
+            close(m_ring_fd);
+        }
+    }
+
+    std::error_code ReadBlock(size_t offset, size_t size, char* buffer) override
+    {
+        assert(buffer);
+        assert(m_ring_fd != -1);
+        assert(m_num_submitted - m_num_completed < m_queue_depth);
+
+        ++m_num_requests;
+
+        auto t1 = std::chrono::steady_clock::now();
+
+        auto& request = m_requests[m_num_submitted % kMaxQueueDepth];
+
+        if (m_direct) {
+            size = DirectReadSize(offset, size, m_file_size);
+        }
+
+        request = Request{ offset, size, buffer, iovec{ buffer, size }, 0, true };
+
+        auto tail = *m_sq_tail;
+        auto sqe  = &m_sqes[tail & m_sq_mask];
+
+        memset(sqe, 0, sizeof(io_uring_sqe));
+
+        if (auto index = FindRegisteredBuffer(buffer); index < m_num_buffers) {
+            sqe->opcode    = IORING_OP_READ_FIXED;
+            sqe->addr      = reinterpret_cast<std::uintptr_t>(buffer);
+            sqe->len       = static_cast<unsigned>(size);
+            sqe->buf_index = static_cast<uint16_t>(index);
+        } else {
+            sqe->opcode = IORING_OP_READV;
+            sqe->addr   = reinterpret_cast<std::uintptr_t>(&request.iov);
+            sqe->len    = 1;
+        }
+
+        sqe->fd        = m_fixed_file ? 0 : m_fd;
+        sqe->flags     = m_fixed_file ? IOSQE_FIXED_FILE : 0;
+        sqe->off       = offset;
+        sqe->user_data = m_num_submitted;
+
+        m_sq_array[tail & m_sq_mask] = tail & m_sq_mask;
+
+        __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        auto error = std::error_code();
+        auto rc    = long{};
+
+        do {
+            rc = syscall(__NR_io_uring_enter, m_ring_fd, 1, 0, 0, nullptr, 0);
+        } while (rc == -1 && errno == EINTR);
+
+        if (rc == 1) {
+            ++m_num_submitted;
+        } else {
+            error = std::error_code(rc == -1 ? errno : EAGAIN, std::system_category());
+            __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+        }
+
+        auto t2 = std::chrono::steady_clock::now();
+
+        m_submit_time += t2 - t1;
+
+        return error;
+    }
+
+    ReadResult WaitForResult() override
+    {
+        assert(m_num_completed < m_num_submitted);
+
+        auto t1 = std::chrono::steady_clock::now();
+
+        auto& request = m_requests[m_num_completed % kMaxQueueDepth];
+        auto  error   = std::error_code();
+
+        while (request.pending && !error) {
+            error = ReapCompletions();
+        }
+
+        ++m_num_completed;
+
+        auto bytes_read = size_t{};
+
+        if (!error && request.result < 0) {
+            error = std::error_code(-request.result, std::system_category());
+        }
+
+        if (!error) {
+            bytes_read = static_cast<size_t>(request.result);
+
+            // complete short reads that stopped before the end of file
+            while (bytes_read < request.size && request.offset + bytes_read < m_file_size) {
+                auto buffer = request.buffer + bytes_read;
+                auto size   = request.size - bytes_read;
+                auto offset = static_cast<off64_t>(request.offset + bytes_read);
+                auto result = pread64(m_fd, buffer, size, offset);
+                if (result < 0) {
+                    error = std::error_code(errno, std::system_category());
+                    break;
+                }
+                if (result == 0) {
+                    break;
+                }
+                bytes_read += static_cast<size_t>(result);
+            }
+        }
+
+        auto t2 = std::chrono::steady_clock::now();
+
+        m_wait_time += t2 - t1;
+
+        if (error) {
+            return ReadResult{ 0, error };
+        }
+
+        m_bytes_read += bytes_read;
+
+        return ReadResult{ bytes_read, std::error_code() };
+    }
+
+    const char* Name() const noexcept override { return m_direct ? "io_uring (O_DIRECT)" : "io_uring"; }
+
+    size_t QueueDepth() const noexcept override { return m_queue_depth; }
+
+    void RegisterBuffers(const std::vector<char*>& buffers, size_t size) noexcept override
+    {
+        if (m_ring_fd == -1 || buffers.empty() || buffers.size() > m_buffers.size()) {
+            return;
+        }
+
+        auto iovecs = std::array<iovec, kMaxQueueDepth + 1>();
+
+        for (size_t i = 0; i != buffers.size(); ++i) {
+            iovecs[i] = iovec{ buffers[i], size };
+        }
+
+        // registered buffers are an optimization; ignore failure (e.g. RLIMIT_MEMLOCK exceeded)
+        auto n = static_cast<unsigned>(buffers.size());
+        if (0 == syscall(__NR_io_uring_register, m_ring_fd, IORING_REGISTER_BUFFERS, iovecs.data(), n)) {
+            std::copy(buffers.begin(), buffers.end(), m_buffers.begin());
+            m_num_buffers = buffers.size();
+            m_buffer_size = size;
+        }
+    }
+
+  private:
+    struct Request final {
+        size_t  offset{};
+        size_t  size{};
+        char*   buffer{};
+        iovec   iov{};
+        int32_t result{};
+        bool    pending{};
+    };
+
+    void* Map(size_t size, off_t offset) noexcept
+    {
+        auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    size_t FindRegisteredBuffer(const char* ptr) const noexcept
+    {
+        for (size_t i = 0; i != m_num_buffers; ++i) {
+            if (ptr >= m_buffers[i] && ptr < m_buffers[i] + m_buffer_size) {
+                return i;
+            }
+        }
+        return m_num_buffers;
+    }
+
+    std::error_code ReapCompletions() noexcept
+    {
+        auto head = *m_cq_head;
+        auto tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            auto rc = syscall(__NR_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (rc == -1 && errno != EINTR) {
+                return std::error_code(errno, std::system_category());
+            }
+            return {};
+        }
+
+        for (; head != tail; ++head) {
+            const auto& cqe     = m_cqes[head & m_cq_mask];
+            auto&       request = m_requests[cqe.user_data % kMaxQueueDepth];
+            request.result      = cqe.res;
+            request.pending     = false;
+        }
+
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+
+        return {};
+    }
+
+    int           m_fd = -1;
+    int           m_ring_fd = -1;
+    bool          m_direct{};
+    size_t        m_file_size{};
+    size_t        m_queue_depth{};
+    bool          m_fixed_file{};
+    void*         m_sq_ring{};
+    void*         m_cq_ring{};
+    io_uring_sqe* m_sqes{};
+    size_t        m_sq_ring_size{};
+    size_t        m_cq_ring_size{};
+    size_t        m_sqes_size{};
+    unsigned*     m_sq_tail{};
+    unsigned      m_sq_mask{};
+    unsigned*     m_sq_array{};
+    unsigned*     m_cq_head{};
+    unsigned*     m_cq_tail{};
+    unsigned      m_cq_mask{};
+    io_uring_cqe* m_cqes{};
+    size_t        m_num_submitted{};
+    size_t        m_num_completed{};
+
+    std::array<Request, kMaxQueueDepth>   m_requests{};
+    std::array<char*, kMaxQueueDepth + 1> m_buffers{};
+    size_t                                m_num_buffers{};
+    size_t                                m_buffer_size{};
+};
+
+#endif
+
 #elif _WIN32
 
 inline auto AlignedAllocate(size_t size, size_t alignment)
@@ -4958,9 +6098,51 @@ struct AlignedDeleter final {
     void operator()(void* ptr) const { _aligned_free(ptr); }
 };
 
+// Allocates size bytes (a multiple of kHugePageSize) of large pages if the process holds the privilege to lock pages
+// in memory, or else of regular pages. Returns nullptr if the memory could not be allocated.
+inline void* AllocateHugePages(size_t size) noexcept
+{
+    if (auto minimum = GetLargePageMinimum(); minimum && size % minimum == 0) {
+        if (auto data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE)) {
+            return data;
+        }
+    }
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+inline void FreeHugePages(void* data, [[maybe_unused]] size_t size) noexcept
+{
+    VirtualFree(data, 0, MEM_RELEASE);
+}
+
+// Number of page faults that the process has incurred so far.
+inline size_t PageFaultCount() noexcept
+{
+    auto counters = PROCESS_MEMORY_COUNTERS{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PageFaultCount;
+}
+
+// Pins the calling thread to the given CPUs (in its processor group). Returns false if the thread could not be pinned.
+inline bool SetThreadAffinity(const std::vector<size_t>& cpus) noexcept
+{
+    auto mask = DWORD_PTR{};
+
+    for (auto cpu : cpus) {
+        if (cpu < 8 * sizeof(DWORD_PTR)) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+
+    return mask != 0 && 0 != SetThreadAffinityMask(GetCurrentThread(), mask);
+}
+
 class File final {
   public:
-    File(const std::filesystem::path& filepath)
+    // reads always bypass the file system cache (FILE_FLAG_NO_BUFFERING)
+    File(const std::filesystem::path& filepath, [[maybe_unused]] bool direct = false)
     {
         auto filepath_string = filepath.string();
 
@@ -5012,6 +6194,56 @@ class File final {
     std::error_code m_error{};
 };
 
+class FileMapping final {
+  public:
+    // copy_on_write: the pages may be written to; writes are private to the process and never reach the file
+    FileMapping(const File& file, [[maybe_unused]] bool populate, bool copy_on_write = false) noexcept
+    {
+        auto protection = copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY;
+        auto access     = copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ;
+
+        m_mapping = CreateFileMappingA(file.handle(), nullptr, protection, 0, 0, nullptr);
+
+        if (m_mapping == nullptr) {
+            m_error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+            return;
+        }
+
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, access, 0, 0, 0));
+
+        if (m_data == nullptr) {
+            m_error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+            return;
+        }
+
+        m_size = file.size();
+    }
+    FileMapping(const FileMapping&)            = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+    FileMapping(FileMapping&&)                 = delete;
+    FileMapping& operator=(FileMapping&&)      = delete;
+    ~FileMapping() noexcept
+    {
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+    }
+
+    explicit operator bool() const noexcept { return m_data != nullptr; }
+    auto     data() const noexcept { return m_data; }
+    auto     size() const noexcept { return m_size; }
+    auto     error() const noexcept { return m_error; }
+
+  private:
+    HANDLE          m_mapping{};
+    const char*     m_data{};
+    size_t          m_size{};
+    std::error_code m_error{};
+};
+
 struct FileReader : Reader {
     FileReader(const File& file)
     {
@@ -5086,6 +6318,8 @@ struct FileReader : Reader {
         return { bytes_read, std::error_code() };
     }
 
+    const char* Name() const noexcept override { return "overlapped"; }
+
   private:
     HANDLE     m_handle{};
     HANDLE     m_file{};
@@ -5103,9 +6337,37 @@ struct AlignedDeleter final {
     void operator()(void* ptr) const { free(ptr); }
 };
 
+// macOS has no user-controlled huge pages for anonymous memory, so this maps size bytes of regular pages. Returns
+// nullptr if the memory could not be mapped.
+inline void* AllocateHugePages(size_t size) noexcept
+{
+    auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    return data == MAP_FAILED ? nullptr : data;
+}
+
+inline void FreeHugePages(void* data, size_t size) noexcept
+{
+    munmap(data, size);
+}
+
+// Number of page faults (minor and major) that the process has incurred so far.
+inline size_t PageFaultCount() noexcept
+{
+    auto usage = rusage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_minflt + usage.ru_majflt);
+}
+
+// macOS does not support pinning threads to CPUs.
+inline bool SetThreadAffinity([[maybe_unused]] const std::vector<size_t>& cpus) noexcept
+{
+    return false;
+}
+
 class File final {
   public:
-    File(const std::filesystem::path& filepath)
+    // reads always bypass the page cache (see FileReader)
+    File(const std::filesystem::path& filepath, [[maybe_unused]] bool direct = false)
     {
         auto filepath_string = filepath.string();
 
@@ -5142,6 +6404,51 @@ class File final {
     std::error_code m_error{};
 };
 
+class FileMapping final {
+  public:
+    // copy_on_write: the pages may be written to; writes are private to the process and never reach the file
+    FileMapping(const File& file, [[maybe_unused]] bool populate, bool copy_on_write = false) noexcept
+    {
+        auto protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+
+        auto ptr = mmap(nullptr, file.size(), protection, MAP_PRIVATE, file.handle(), 0);
+
+        if (ptr == MAP_FAILED) {
+            m_error = std::error_code(errno, std::system_category());
+            return;
+        }
+
+        m_data = static_cast<const char*>(ptr);
+        m_size = file.size();
+
+        // hints only; ignore failure (there is no MAP_POPULATE on macOS)
+        if (!copy_on_write) {
+            madvise(ptr, m_size, MADV_SEQUENTIAL);
+        }
+        madvise(ptr, m_size, MADV_WILLNEED);
+    }
+    FileMapping(const FileMapping&)            = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+    FileMapping(FileMapping&&)                 = delete;
+    FileMapping& operator=(FileMapping&&)      = delete;
+    ~FileMapping() noexcept
+    {
+        if (m_data) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    explicit operator bool() const noexcept { return m_data != nullptr; }
+    auto     data() const noexcept { return m_data; }
+    auto     size() const noexcept { return m_size; }
+    auto     error() const noexcept { return m_error; }
+
+  private:
+    const char*     m_data{};
+    size_t          m_size{};
+    std::error_code m_error{};
+};
+
 struct FileReader : Reader {
     FileReader(const File& file) noexcept : m_fd{ file.handle() }
     {
@@ -5204,6 +6511,8 @@ struct FileReader : Reader {
         return ReadResult{ bytes_read, std::error_code() };
     }
 
+    const char* Name() const noexcept override { return "pread"; }
+
   private:
     int    m_fd = -1;
     off_t  m_offset{};
@@ -5215,10 +6524,463 @@ struct FileReader : Reader {
 
 } // namespace sys
 
-using DataSource = std::variant<sys::File*, std::istream*>;
+// Serves allocations of at least kMinHugePageAllocation bytes from huge pages (see sys::AllocateHugePages), and
+// smaller ones from the heap. Used for parse buffers and Result arrays when Options::huge_pages is set.
+class HugePageResource final : public MemoryResource {
+  public:
+    // never destroyed, so that arrays that outlive static destruction can still be freed
+    static HugePageResource* Instance()
+    {
+        static auto* resource = new HugePageResource();
+        return resource;
+    }
 
-struct StreamReader : Reader {
-    StreamReader(std::istream* is) noexcept : m_stream(is)
+    void* Allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes < kMinHugePageAllocation) {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        if (auto data = sys::AllocateHugePages(RoundUp(bytes))) {
+            return data;
+        }
+        throw std::bad_alloc();
+    }
+
+    void Deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes < kMinHugePageAllocation) {
+            ::operator delete(pointer, std::align_val_t(alignment));
+        } else {
+            sys::FreeHugePages(pointer, RoundUp(bytes));
+        }
+    }
+
+  private:
+    static size_t RoundUp(size_t bytes) noexcept { return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize; }
+};
+
+// Resource that Result arrays are allocated from (nullptr: new[]).
+inline MemoryResource* ResultMemoryResource(const Options& options)
+{
+    if (options.memory_resource) {
+        return options.memory_resource;
+    }
+    return options.huge_pages ? HugePageResource::Instance() : nullptr;
+}
+
+// Frees large allocations on a background thread, so that ParseFile, ParseStream and Triangulate can return without
+// waiting for them to be freed. At most kMaxDeferredFrees allocations wait in the queue; when it is full, memory is
+// freed on the calling thread instead. The thread is started on first use and joined at program exit, after it has
+// freed everything still in the queue.
+class DeferredFreeQueue final {
+  public:
+    static DeferredFreeQueue& Instance()
+    {
+        static auto queue = DeferredFreeQueue();
+        return queue;
+    }
+
+    DeferredFreeQueue(const DeferredFreeQueue&)            = delete;
+    DeferredFreeQueue& operator=(const DeferredFreeQueue&) = delete;
+    ~DeferredFreeQueue() noexcept
+    {
+        {
+            auto lock = std::lock_guard(m_mutex);
+            m_stop    = true;
+        }
+        m_wakeup.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    template <typename T>
+    void Push(T&& garbage)
+    {
+        auto item = std::shared_ptr<void>(std::make_shared<std::decay_t<T>>(std::forward<T>(garbage)));
+        {
+            auto lock = std::lock_guard(m_mutex);
+            if (m_stop || m_queue.size() == kMaxDeferredFrees) {
+                return; // item is freed on this thread
+            }
+            if (!m_thread.joinable()) {
+                m_thread = std::thread([this] { Run(); });
+            }
+            m_queue.push_back(std::move(item));
+        }
+        m_wakeup.notify_one();
+    }
+
+    // Waits until all queued memory has been freed.
+    void Flush()
+    {
+        auto lock = std::unique_lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+    }
+
+  private:
+    DeferredFreeQueue() noexcept = default;
+
+    void Run()
+    {
+        auto lock = std::unique_lock(m_mutex);
+        while (true) {
+            m_wakeup.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+            if (m_queue.empty()) {
+                break;
+            }
+            auto item = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_busy = true;
+            lock.unlock();
+            item.reset();
+            lock.lock();
+            m_busy = false;
+            if (m_queue.empty()) {
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    std::deque<std::shared_ptr<void>> m_queue{};
+    std::thread                       m_thread{};
+    bool                              m_busy{}; // an item taken off the queue is being freed
+    bool                              m_stop{};
+    std::mutex                        m_mutex{}; // protects m_queue, m_thread, m_busy and m_stop
+    std::condition_variable           m_wakeup{};
+    std::condition_variable           m_idle{};
+};
+
+using AlignedBuffer = std::unique_ptr<char, sys::AlignedDeleter>;
+
+// Buffers that a ParserContext keeps between calls.
+struct ParserState final {
+    std::mutex                 mutex{};            // held by the call that is using the buffers
+    std::vector<Chunk>         chunks{};           // parsed into by ParseFile and ParseStream
+    std::vector<AlignedBuffer> block_buffers{};    // kMaxLineLength + kBlockSize bytes each (ParseFile only)
+    std::vector<AlignedBuffer> batch_buffers{};    // kMaxLineLength + kStreamBatchSize bytes each (ParseStream only)
+    std::mutex                 block_mutex{};      // protects block_buffers while parsing threads take and return them
+    MergeTasks                 merge_tasks{};      // tasks computed by Merge
+    MergeTasks                 subdivided_tasks{}; // merge tasks split up for parallel execution
+};
+
+struct ParserContextAccess final {
+    static ParserState* State(ParserContext* context) noexcept { return context->m_state.get(); }
+};
+
+// Gives a call exclusive use of the buffers kept by a ParserContext, unless another call is already using them.
+class ParserStateLease final {
+  public:
+    explicit ParserStateLease(ParserContext* context) noexcept
+    {
+        if (auto state = context ? ParserContextAccess::State(context) : nullptr; state && state->mutex.try_lock()) {
+            m_state = state;
+        }
+    }
+    ParserStateLease(const ParserStateLease&)            = delete;
+    ParserStateLease& operator=(const ParserStateLease&) = delete;
+    ~ParserStateLease() noexcept
+    {
+        if (m_state) {
+            m_state->mutex.unlock();
+        }
+    }
+
+    ParserState* get() const noexcept { return m_state; }
+
+  private:
+    ParserState* m_state{};
+};
+
+// Takes count block buffers, reusing the ones kept by state before allocating new ones.
+inline std::vector<AlignedBuffer> AcquireBlockBuffers(ParserState* state, size_t count)
+{
+    auto buffers = std::vector<AlignedBuffer>();
+
+    buffers.reserve(count);
+
+    if (state) {
+        auto lock = std::lock_guard(state->block_mutex);
+        while (buffers.size() != count && !state->block_buffers.empty()) {
+            buffers.push_back(std::move(state->block_buffers.back()));
+            state->block_buffers.pop_back();
+        }
+    }
+
+    while (buffers.size() != count) {
+        buffers.emplace_back(sys::AlignedAllocate(kMaxLineLength + kBlockSize, 4_KiB));
+    }
+
+    return buffers;
+}
+
+// Hands block buffers back to state, to be reused by later calls; without state, they are freed.
+inline void ReleaseBlockBuffers(ParserState* state, std::vector<AlignedBuffer>* buffers)
+{
+    if (state) {
+        auto lock = std::lock_guard(state->block_mutex);
+        std::move(buffers->begin(), buffers->end(), std::back_inserter(state->block_buffers));
+    }
+    buffers->clear();
+}
+
+// Number of threads available for parallel work.
+inline size_t AvailableThreads(const SharedContext::Thread& thread) noexcept
+{
+    auto num_threads = std::max(size_t(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+
+    if (thread.pool) {
+        num_threads = thread.pool->Size();
+    } else if (!thread.cpu_affinity.empty()) {
+        num_threads = std::min(num_threads, thread.cpu_affinity.size());
+    }
+
+    if (thread.max_threads > 0) {
+        num_threads = std::min(num_threads, thread.max_threads);
+    }
+
+    return num_threads;
+}
+
+// Runs function(args...) on the thread pool if there is one; otherwise, runs it on a new detached thread.
+template <typename Function, typename... Args>
+void RunAsync(const SharedContext::Thread& thread, Function function, Args... args)
+{
+    if (thread.pool) {
+        ThreadPoolAccess::Submit(thread.pool, [function, args...]() { function(args...); });
+    } else if (!thread.cpu_affinity.empty()) {
+        auto pinned = [cpus = thread.cpu_affinity, function, args...]() {
+            sys::SetThreadAffinity(cpus);
+            function(args...);
+        };
+        std::thread(std::move(pinned)).detach();
+    } else {
+        std::thread(function, std::move(args)...).detach();
+    }
+}
+
+// Waits for the future to become ready. If there is a thread pool, pending tasks are run while waiting.
+inline void Wait(const SharedContext::Thread& thread, std::future<void> future)
+{
+    if (thread.pool) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!ThreadPoolAccess::RunPendingTask(thread.pool)) {
+                future.wait();
+            }
+        }
+    } else {
+        future.wait();
+    }
+}
+
+inline int CountTrailingZeros(uint64_t value) noexcept
+{
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Sets bit i of mask[i / 64] if data[i] is a newline; size need not be a multiple of 64.
+inline void IndexNewlinesScalar(const char* data, size_t size, uint64_t* mask) noexcept
+{
+    std::fill_n(mask, (size + 63) / 64, uint64_t{});
+
+    auto first = data;
+    auto last  = data + size;
+
+    while (auto ptr = static_cast<const char*>(memchr(first, '\n', static_cast<size_t>(last - first)))) {
+        auto pos = static_cast<size_t>(ptr - data);
+        mask[pos / 64] |= uint64_t(1) << (pos % 64);
+        first = ptr + 1;
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RAPIDOBJ_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RAPIDOBJ_TARGET_AVX2
+#endif
+
+// SSE2 is part of the x86-64 baseline, so it does not need to be detected.
+inline void IndexNewlinesSse2(const char* data, size_t size, uint64_t* mask) noexcept
+{
+    auto newline = _mm_set1_epi8('\n');
+    auto words   = size / 64;
+
+    for (size_t i = 0; i != words; ++i, data += 64) {
+        auto bits = uint64_t{};
+        for (int j = 0; j != 4; ++j) {
+            auto chunk   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * j));
+            auto matches = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+            bits |= uint64_t(matches) << (16 * j);
+        }
+        mask[i] = bits;
+    }
+
+    if (auto tail = size % 64) {
+        IndexNewlinesScalar(data, tail, mask + words);
+    }
+}
+
+RAPIDOBJ_TARGET_AVX2 inline void IndexNewlinesAvx2(const char* data, size_t size, uint64_t* mask) noexcept
+{
+    auto newline = _mm256_set1_epi8('\n');
+    auto words   = size / 64;
+
+    for (size_t i = 0; i != words; ++i, data += 64) {
+        auto lo      = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        auto hi      = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+        auto lo_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)));
+        auto hi_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)));
+        mask[i]      = uint64_t(lo_bits) | (uint64_t(hi_bits) << 32);
+    }
+
+    if (auto tail = size % 64) {
+        IndexNewlinesScalar(data, tail, mask + words);
+    }
+}
+
+inline bool CpuSupportsAvx2() noexcept
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+// NEON is part of the AArch64 baseline, so it does not need to be detected.
+inline void IndexNewlinesNeon(const char* data, size_t size, uint64_t* mask) noexcept
+{
+    static const uint8_t kBitWeights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+    auto newline = vdupq_n_u8('\n');
+    auto weights = vld1q_u8(kBitWeights);
+    auto words   = size / 64;
+
+    for (size_t i = 0; i != words; ++i, data += 64) {
+        auto ptr  = reinterpret_cast<const uint8_t*>(data);
+        auto m0   = vandq_u8(vceqq_u8(vld1q_u8(ptr), newline), weights);
+        auto m1   = vandq_u8(vceqq_u8(vld1q_u8(ptr + 16), newline), weights);
+        auto m2   = vandq_u8(vceqq_u8(vld1q_u8(ptr + 32), newline), weights);
+        auto m3   = vandq_u8(vceqq_u8(vld1q_u8(ptr + 48), newline), weights);
+        auto sum  = vpaddq_u8(vpaddq_u8(m0, m1), vpaddq_u8(m2, m3));
+        sum       = vpaddq_u8(sum, sum);
+        mask[i]   = vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+    }
+
+    if (auto tail = size % 64) {
+        IndexNewlinesScalar(data, tail, mask + words);
+    }
+}
+
+#endif
+
+struct NewlineKernel final {
+    void (*function)(const char* data, size_t size, uint64_t* mask) noexcept;
+    const char* name;
+};
+
+// The kernel is selected once, at run time, based on the features of the CPU.
+inline NewlineKernel SelectNewlineKernel() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    if (CpuSupportsAvx2()) {
+        return { IndexNewlinesAvx2, "avx2" };
+    }
+    return { IndexNewlinesSse2, "sse2" };
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return { IndexNewlinesNeon, "neon" };
+#else
+    return { IndexNewlinesScalar, "scalar" };
+#endif
+}
+
+inline const NewlineKernel& GetNewlineKernel() noexcept
+{
+    static const auto kernel = SelectNewlineKernel();
+    return kernel;
+}
+
+// Index of newline positions, used in place of memchr to find the end of each line. Rather than searching for
+// newlines one line at a time, a whole window of text (up to kBlockSize bytes) is scanned in a single vectorized pass
+// and newline positions are recorded in a bitmap; lines are then found by scanning the bitmap.
+class NewlineIndex final {
+  public:
+    NewlineIndex() : m_mask(kBlockSize / 64), m_kernel(GetNewlineKernel().function) {}
+
+    // Must be called when the text inside the window changes (e.g. when a buffer is reused).
+    void Reset() noexcept { m_begin = m_end = nullptr; }
+
+    // Same as memchr(first, '\n', size).
+    const char* Find(const char* first, size_t size) noexcept
+    {
+        auto last = first + size;
+
+        while (first < last) {
+            if (first < m_begin || first >= m_end) {
+                Build(first, std::min(static_cast<size_t>(last - first), kBlockSize));
+            }
+
+            auto offset = static_cast<size_t>(first - m_begin);
+            auto limit  = static_cast<size_t>(std::min(last, m_end) - m_begin);
+            auto word   = offset / 64;
+            auto bits   = m_mask[word] & (~uint64_t{} << (offset % 64));
+
+            while (bits == 0 && ++word * 64 < limit) {
+                bits = m_mask[word];
+            }
+
+            if (bits != 0) {
+                auto pos = word * 64 + static_cast<size_t>(CountTrailingZeros(bits));
+                return pos < limit ? m_begin + pos : nullptr;
+            }
+
+            if (last <= m_end) {
+                return nullptr;
+            }
+
+            first = m_end;
+        }
+
+        return nullptr;
+    }
+
+  private:
+    void Build(const char* begin, size_t size) noexcept
+    {
+        m_kernel(begin, size, m_mask.data());
+        m_begin = begin;
+        m_end   = begin + size;
+    }
+
+    std::vector<uint64_t> m_mask{};
+    void (*m_kernel)(const char*, size_t, uint64_t*) noexcept {};
+    const char* m_begin{};
+    const char* m_end{};
+};
+
+using DataSource = std::variant<sys::File*, std::istream*>;
+
+struct StreamReader : Reader {
+    StreamReader(std::istream* is) noexcept : m_stream(is)
     {
         assert(is);
         if (!is->good()) {
@@ -5260,6 +7022,8 @@ struct StreamReader : Reader {
         return result;
     }
 
+    const char* Name() const noexcept override { return "stream"; }
+
   private:
     std::istream* m_stream{};
     size_t        m_offset{};
@@ -5267,17 +7031,24 @@ struct StreamReader : Reader {
     char*         m_buffer{};
 };
 
-inline std::unique_ptr<Reader> CreateReader(sys::File* file)
+inline std::unique_ptr<Reader> CreateReader(sys::File* file, [[maybe_unused]] const SharedContext::Io& io)
 {
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+    if (io.read == Read::IoUring) {
+        if (auto reader = std::make_unique<sys::UringReader>(*file, io.queue_depth); !reader->Error()) {
+            return reader;
+        }
+    }
+#endif
     return std::make_unique<sys::FileReader>(*file);
 }
-inline std::unique_ptr<Reader> CreateReader(std::istream* is)
+inline std::unique_ptr<Reader> CreateReader(std::istream* is, const SharedContext::Io&)
 {
     return std::make_unique<StreamReader>(is);
 }
-inline std::unique_ptr<Reader> CreateReader(DataSource source)
+inline std::unique_ptr<Reader> CreateReader(DataSource source, const SharedContext::Io& io)
 {
-    return std::visit([](auto arg) { return CreateReader(arg); }, source);
+    return std::visit([&io](auto arg) { return CreateReader(arg, io); }, source);
 }
 
 inline std::string ToString(std::chrono::nanoseconds time, int width = 0)
@@ -5395,8 +7166,9 @@ inline std::string DumpDebug(const SharedContext& context)
         auto submit_ns  = context.debug.io.submit_time[i];
         auto wait_ns    = context.debug.io.wait_time[i];
         auto total_ns   = submit_ns.count() + wait_ns.count();
-        auto average_ns = total_ns / n;
+        auto average_ns = n ? total_ns / n : 0;
         auto thread     = ToString(i + 1, 3);
+        auto reader     = std::string(context.debug.io.reader[i] ? context.debug.io.reader[i] : "-");
         auto requests   = ToString(n, 5);
         auto submit     = ToString(std::chrono::nanoseconds(submit_ns), 9);
         auto wait       = ToString(std::chrono::nanoseconds(wait_ns), 9);
@@ -5408,7 +7180,8 @@ inline std::string DumpDebug(const SharedContext& context)
         num_bytes_read += context.debug.io.num_bytes_read[i];
 
         text.append(thread);
-        text.append(": blk").append(requests);
+        text.append(": ").append(reader).append(reader.size() < 19 ? 19 - reader.size() : 0, ' ');
+        text.append("    blk").append(requests);
         text.append("    read").append(submit);
         text.append("    wait").append(wait);
         text.append("    sum").append(total);
@@ -5423,7 +7196,7 @@ inline std::string DumpDebug(const SharedContext& context)
     for (size_t i = 0; i != context.debug.io.num_requests.size(); ++i) {
         auto parse_ns      = context.debug.parse.time[i];
         auto io_ns         = context.debug.io.submit_time[i] + context.debug.io.wait_time[i];
-        auto io_percentage = static_cast<int>(0.5f + 100.0f * io_ns.count() / parse_ns.count());
+        auto io_percentage = parse_ns.count() ? static_cast<int>(0.5f + 100.0f * io_ns.count() / parse_ns.count()) : 0;
         auto thread        = ToString(i + 1, 3);
         auto parse         = ToString(parse_ns, 9);
 
@@ -5451,16 +7224,99 @@ inline std::string DumpDebug(const SharedContext& context)
     text.append(ToString(merge_total, 10));
     text.append(" (").append(std::to_string(merge_percentage)).append("%)\n");
     text.append("Parse Rate: ").append(RateToString(bytes_per_second, 12)).append("\n");
+    text.append("Reallocs:   ").append(ToString(context.debug.parse.num_reallocations, 10));
+    text.append(" (").append(ToString(context.debug.parse.num_bytes_copied / 1024)).append(" KB copied)\n");
+    text.append("Faults:     ").append(ToString(context.debug.parse.num_page_faults, 10)).append(" (parse)");
+    text.append(ToString(context.debug.merge.num_page_faults, 10)).append(" (merge)\n");
+    text.append("Line Index: ").append(GetNewlineKernel().name).append("\n");
 
     return text;
 }
 
+// Fast path for the short, fixed-point decimals (e.g. -0.123456) that make up most .obj files. The digits are
+// accumulated in a single pass and the value is computed as mantissa / 10^n in double precision, which is exact for
+// up to 15 digits and then rounded to float. Numbers with an exponent or more than 15 digits, and the rare results
+// that land exactly halfway between two floats, are left to fast_float. Because both paths are correctly rounded,
+// the result is bit-identical to fast_float. Define RAPIDOBJ_DISABLE_FAST_REALS to always use fast_float.
+#if !defined(RAPIDOBJ_DISABLE_FAST_REALS) && (FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1)
+#define RAPIDOBJ_FAST_REALS 1
+#else
+#define RAPIDOBJ_FAST_REALS 0
+#endif
+
+// Parses a short decimal number; returns nullptr if the number must be parsed by fast_float.
+inline const char* ParseShortDecimal(const char* first, const char* last, float* out) noexcept
+{
+    static constexpr double kPowersOfTen[] = { 1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                               1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+    auto ptr      = first;
+    bool negative = ptr != last && *ptr == '-';
+
+    ptr += negative;
+
+    auto mantissa = uint64_t{};
+    auto digits   = ptr;
+
+    while (ptr != last && static_cast<unsigned char>(*ptr - '0') < 10) {
+        mantissa = 10 * mantissa + static_cast<unsigned char>(*ptr - '0');
+        ++ptr;
+    }
+
+    auto num_digits   = static_cast<size_t>(ptr - digits);
+    auto num_fraction = size_t{};
+
+    if (ptr != last && *ptr == '.') {
+        digits = ++ptr;
+        while (ptr != last && static_cast<unsigned char>(*ptr - '0') < 10) {
+            mantissa = 10 * mantissa + static_cast<unsigned char>(*ptr - '0');
+            ++ptr;
+        }
+        num_fraction = static_cast<size_t>(ptr - digits);
+        num_digits += num_fraction;
+    }
+
+    // mantissa and power of ten must both be exact doubles
+    if (num_digits == 0 || num_digits > 15) {
+        return nullptr;
+    }
+
+    if (ptr != last && (*ptr == 'e' || *ptr == 'E')) {
+        return nullptr;
+    }
+
+    auto value = static_cast<double>(mantissa) / kPowersOfTen[num_fraction];
+
+    // rounding to double and then to float is only wrong if the double lands on a midpoint between two floats
+    auto bits = uint64_t{};
+    memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x1FFFFFFF) == 0x10000000) {
+        return nullptr;
+    }
+
+    auto result = static_cast<float>(value);
+
+    *out = negative ? -result : result;
+
+    return ptr;
+}
+
+inline fast_float::from_chars_result FromChars(const char* first, const char* last, float& value) noexcept
+{
+#if RAPIDOBJ_FAST_REALS
+    if (auto ptr = ParseShortDecimal(first, last, &value)) {
+        return { ptr, std::errc() };
+    }
+#endif
+    return fast_float::from_chars(first, last, value);
+}
+
 inline auto ParseXReals(std::string_view line, size_t max_count, float* out)
 {
     size_t count = 0;
     while (!line.empty() && count < max_count) {
         TrimLeft(line);
-        auto [ptr, rc] = fast_float::from_chars(line.data(), line.data() + line.size(), *out);
+        auto [ptr, rc] = FromChars(line.data(), line.data() + line.size(), *out);
         if (rc != kSuccess) {
             return std::make_pair(count, line);
         }
@@ -5479,7 +7335,7 @@ inline auto ParseXReals(std::string_view line, size_t max_count, Buffer<float>*
     while (!line.empty() && count < max_count) {
         TrimLeft(line);
         auto value     = float();
-        auto [ptr, rc] = fast_float::from_chars(line.data(), line.data() + line.size(), value);
+        auto [ptr, rc] = FromChars(line.data(), line.data() + line.size(), value);
         if (rc != kSuccess) {
             return std::make_pair(count, line);
         }
@@ -5522,7 +7378,7 @@ inline size_t ParseReals(std::string_view text, size_t max_count, float* out)
     TrimLeft(text);
 
     while (!text.empty() && count < max_count) {
-        auto [ptr, rc] = fast_float::from_chars(text.data(), text.data() + text.size(), *out);
+        auto [ptr, rc] = FromChars(text.data(), text.data() + text.size(), *out);
         if (rc != kSuccess) {
             return 0;
         }
@@ -5555,7 +7411,7 @@ inline size_t ParseReals(std::string_view text, size_t max_count, Buffer<float>*
 
     while (!text.empty() && count < max_count) {
         auto value     = float();
-        auto [ptr, rc] = fast_float::from_chars(text.data(), text.data() + text.size(), value);
+        auto [ptr, rc] = FromChars(text.data(), text.data() + text.size(), value);
         if (rc != kSuccess) {
             return 0;
         }
@@ -5573,6 +7429,41 @@ inline size_t ParseReals(std::string_view text, size_t max_count, Buffer<float>*
     return text.empty() ? count : 0;
 }
 
+// Parses a decimal integer, accepting the same input as std::from_chars; returns nullptr on failure. Indices of up
+// to nine digits, which covers every realistic mesh, are converted in a single pass without overflow checks.
+inline const char* ParseIndex(const char* first, const char* last, int* out) noexcept
+{
+    auto ptr      = first;
+    bool negative = ptr != last && *ptr == '-';
+
+    ptr += negative;
+
+    auto digits = ptr;
+    auto value  = uint32_t{};
+
+    while (ptr != last && static_cast<unsigned char>(*ptr - '0') < 10 && ptr - digits < 9) {
+        value = 10 * value + static_cast<unsigned char>(*ptr - '0');
+        ++ptr;
+    }
+
+    if (ptr == digits) {
+        return nullptr;
+    }
+
+    if (ptr != last && static_cast<unsigned char>(*ptr - '0') < 10) {
+        auto [end, rc] = std::from_chars(first, last, *out);
+        return rc == kSuccess ? end : nullptr;
+    }
+
+    *out = negative ? -static_cast<int>(value) : static_cast<int>(value);
+
+    return ptr;
+}
+
+// Parses the indices of a face, line or point element. Offset flags are only stored once the first relative (negative)
+// index is seen; until then offset_flags stays empty, which tells the merge step that no index needs an offset. After
+// that, offset_flags holds one entry per index, with the earlier indices marked ApplyOffset::None. If offset_flags is
+// nullptr, the indices belong to the first chunk and relative indices are resolved to their final values here.
 inline auto ParseFace(
     std::string_view     text,
     size_t               position_count,
@@ -5586,35 +7477,37 @@ inline auto ParseFace(
 {
     using std::make_pair;
 
+    auto first = text.data();
+    auto last  = text.data() + text.size();
     auto count = size_t{};
     auto value = 0;
 
     indices->ensure_enough_room_for(max_count);
-    offset_flags->ensure_enough_room_for(max_count);
 
     while (count <= max_count) {
-        TrimLeft(text);
+        while (first != last && (*first == ' ' || *first == '\t')) {
+            ++first;
+        }
 
         // exit if there is nothing left to process
-        if (text.empty()) {
+        if (first == last) {
             break;
         }
 
+        auto flags = static_cast<OffsetFlags>(ApplyOffset::None);
+
         // parse position index
         {
-            auto [ptr, rc] = std::from_chars(text.data(), text.data() + text.size(), value);
-            if (rc != kSuccess) {
+            first = ParseIndex(first, last, &value);
+            if (!first) {
                 return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
             }
-            auto num_parsed = static_cast<size_t>(ptr - text.data());
-            text.remove_prefix(num_parsed);
 
-            offset_flags->push_back(static_cast<OffsetFlags>(ApplyOffset::None));
             if (value > 0) {
                 --value;
             } else if (value < 0) {
                 value += static_cast<int>(position_count);
-                offset_flags->back() |= static_cast<OffsetFlags>(ApplyOffset::Position);
+                flags |= static_cast<OffsetFlags>(ApplyOffset::Position);
             } else {
                 return make_pair(size_t{ 0 }, rapidobj_errc::IndexOutOfBoundsError);
             }
@@ -5626,31 +7519,27 @@ inline auto ParseFace(
             }
         }
 
-        // exit if there is nothing left to process
-        if (text.empty()) {
-            break;
-        }
-
-        // Parse UV
-        if (text.front() == '/') {
-            text.remove_prefix(1);
-            if (text.empty()) {
+        // most vertices are a lone position index followed by whitespace
+        if (first != last && *first == '/') {
+            // Parse UV
+            if (++first == last) {
                 return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
             }
-            if (text.front() != '/') {
+            if (*first != '/') {
                 // parse texcoord index
-                auto [ptr, rc] = std::from_chars(text.data(), text.data() + text.size(), value);
-                if (rc != kSuccess) {
+                first = ParseIndex(first, last, &value);
+                if (!first) {
                     return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
                 }
-                auto num_parsed = static_cast<size_t>(ptr - text.data());
-                text.remove_prefix(num_parsed);
 
                 if (value > 0) {
                     --value;
                 } else if (value < 0) {
                     value += static_cast<int>(texcoord_count);
-                    offset_flags->back() |= static_cast<OffsetFlags>(ApplyOffset::Texcoord);
+                    flags |= static_cast<OffsetFlags>(ApplyOffset::Texcoord);
+                    if (value < 0 && !offset_flags) {
+                        value = kInvalidIndex; // -1 would mean that the index is not present
+                    }
                 } else {
                     return make_pair(size_t{ 0 }, rapidobj_errc::IndexOutOfBoundsError);
                 }
@@ -5660,42 +7549,45 @@ inline auto ParseFace(
                     return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
                 }
             }
-        }
-
-        // exit if there is nothing left to process
-        if (text.empty()) {
-            break;
-        }
 
-        // Parse Normal
-        if (text.front() == '/') {
-            text.remove_prefix(1);
-            if (text.empty()) {
-                return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
-            }
+            // Parse Normal
+            if (first != last && *first == '/') {
+                if (++first == last) {
+                    return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
+                }
 
-            // parse normal index
-            auto [ptr, rc] = std::from_chars(text.data(), text.data() + text.size(), value);
-            if (rc != kSuccess) {
-                return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
-            }
-            auto num_parsed = static_cast<size_t>(ptr - text.data());
-            text.remove_prefix(num_parsed);
+                // parse normal index
+                first = ParseIndex(first, last, &value);
+                if (!first) {
+                    return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
+                }
 
-            if (value > 0) {
-                --value;
-            } else if (value < 0) {
-                value += static_cast<int>(normal_count);
-                offset_flags->back() |= static_cast<OffsetFlags>(ApplyOffset::Normal);
-            } else {
-                return make_pair(size_t{ 0 }, rapidobj_errc::IndexOutOfBoundsError);
-            }
-            if (permitted_flags & ApplyOffset::Normal) {
-                indices->back().normal_index = value;
-            } else {
-                return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
+                if (value > 0) {
+                    --value;
+                } else if (value < 0) {
+                    value += static_cast<int>(normal_count);
+                    flags |= static_cast<OffsetFlags>(ApplyOffset::Normal);
+                    if (value < 0 && !offset_flags) {
+                        value = kInvalidIndex; // -1 would mean that the index is not present
+                    }
+                } else {
+                    return make_pair(size_t{ 0 }, rapidobj_errc::IndexOutOfBoundsError);
+                }
+                if (permitted_flags & ApplyOffset::Normal) {
+                    indices->back().normal_index = value;
+                } else {
+                    return make_pair(size_t{ 0 }, rapidobj_errc::ParseError);
+                }
             }
         }
+
+        // store offset flags once the first relative index is seen, back-filling the preceding indices
+        if (offset_flags && (flags != static_cast<OffsetFlags>(ApplyOffset::None) || offset_flags->size() != 0)) {
+            auto missing = indices->size() - offset_flags->size();
+            offset_flags->ensure_enough_room_for(missing);
+            offset_flags->fill_n(missing - 1, static_cast<OffsetFlags>(ApplyOffset::None));
+            offset_flags->push_back(flags);
+        }
     }
 
     if (count < min_count) {
@@ -6118,15 +8010,15 @@ inline ParseMaterialsResult ParseMaterials(std::string_view text)
     return { std::move(material_map), std::move(materials), Error{} };
 }
 
-inline auto FindBestPath(SharedContext* context)
+inline std::filesystem::path FindBestPath(
+    const std::filesystem::path&              basepath,
+    const std::vector<std::filesystem::path>& paths,
+    const std::string&                        library_name)
 {
-    const auto& basepath = context->material.basepath;
-    const auto& paths    = std::get<std::vector<std::filesystem::path>>(context->material.library->Value());
-
     for (const auto& path : paths) {
         auto bestpath = path.is_absolute() ? path : (basepath / path);
         if (std::filesystem::is_directory(bestpath)) {
-            bestpath /= context->material.library_name;
+            bestpath /= library_name;
         }
         if (std::filesystem::exists(bestpath) && std::filesystem::is_regular_file(bestpath)) {
             return bestpath;
@@ -6136,6 +8028,13 @@ inline auto FindBestPath(SharedContext* context)
     return std::filesystem::path();
 }
 
+inline auto FindBestPath(SharedContext* context)
+{
+    const auto& paths = std::get<std::vector<std::filesystem::path>>(context->material.library->Value());
+
+    return FindBestPath(context->material.basepath, paths, context->material.library_name);
+}
+
 inline auto ParseMaterialLibrary(SharedContext* context)
 {
     if (std::holds_alternative<std::string_view>(context->material.library->Value())) {
@@ -6193,14 +8092,26 @@ inline void DispatchMergeTasks(const MergeTasks& tasks, std::shared_ptr<SharedCo
     }
 }
 
+// Returns an empty task vector that reuses the memory of the kept one (if any).
+inline MergeTasks TakeMergeTasks(MergeTasks* kept)
+{
+    auto tasks = MergeTasks();
+    if (kept) {
+        tasks.swap(*kept);
+        tasks.clear();
+    }
+    return tasks;
+}
+
 inline void MergeSequential(MergeTasks* tasks, std::shared_ptr<SharedContext> context)
 {
-    DispatchMergeTasks(std::vector<MergeTask>(tasks->begin(), tasks->end()), context);
+    DispatchMergeTasks(*tasks, context);
 }
 
 inline void MergeParallel(MergeTasks* merge_tasks, std::shared_ptr<SharedContext> context)
 {
-    auto tasks = MergeTasks();
+    auto state = context->parsing.retained;
+    auto tasks = TakeMergeTasks(state ? &state->subdivided_tasks : nullptr);
     tasks.reserve(merge_tasks->size());
 
     for (auto& merge_task : *merge_tasks) {
@@ -6217,18 +8128,19 @@ inline void MergeParallel(MergeTasks* merge_tasks, std::shared_ptr<SharedContext
         }
     }
 
-    auto threads = std::vector<std::thread>{};
-    threads.reserve(context->thread.concurrency);
-
     context->merging.thread_count = context->thread.concurrency;
 
+    // the tasks are shared by reference; they outlive the threads' use of them, since this function waits
     for (size_t i = 0; i != context->thread.concurrency; ++i) {
-        threads.emplace_back(DispatchMergeTasks, tasks, context);
-        threads.back().detach();
+        RunAsync(context->thread, DispatchMergeTasks, std::cref(tasks), context);
     }
 
     // wait for merging to finish
-    context->merging.completed.get_future().wait();
+    Wait(context->thread, context->merging.completed.get_future());
+
+    if (state) {
+        state->subdivided_tasks.swap(tasks);
+    }
 }
 
 // Merge function helper structs
@@ -6281,10 +8193,24 @@ struct Offset final {
     }
 };
 
-inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedContext> context)
+// Offsets and per-face id sources needed to assemble the result from the parsed chunks.
+struct MergeSources final {
+    ListInfo                       list_info;
+    std::vector<Offset>            offsets;
+    AttributeInfo                  count;
+    std::vector<ShapeRecord>       shape_records;
+    std::vector<FillSrc<uint32_t>> smoothing_src;
+    std::vector<FillSrc<int32_t>>  material_src;
+    Materials                      materials;
+    Error                          error;
+};
+
+inline MergeSources PrepareMerge(const std::vector<Chunk>& chunks, SharedContext* context)
 {
+    auto sources = MergeSources{};
+
     // compute overall sizes of lists
-    auto list_info = ListInfo{};
+    auto& list_info = sources.list_info;
     for (const Chunk& chunk : chunks) {
         list_info += { chunk.mesh.faces.buffer.size(),
                        chunk.shapes.list.size(),
@@ -6293,8 +8219,8 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
     }
 
     // compute offsets for each chunk and total attribute count
-    auto offsets = std::vector<Offset>();
-    auto count   = AttributeInfo{};
+    auto& offsets = sources.offsets;
+    auto& count   = sources.count;
     {
         offsets.reserve(chunks.size());
         auto running = Offset{};
@@ -6307,10 +8233,13 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
     }
 
     // coalesce per-chunk shape records into a single shape records list
-    auto shape_records = std::vector<ShapeRecord>();
+    auto& shape_records = sources.shape_records;
     {
         shape_records.reserve(list_info.shape_records_size + 2);
         shape_records.push_back({});
+        if (auto filter = context->parsing.shape_filter) {
+            shape_records.back().skipped = !(*filter)(shape_records.back().name);
+        }
         for (size_t i = 0; i != chunks.size(); ++i) {
             for (const ShapeRecord& record : chunks[i].shapes.list) {
                 shape_records.push_back(record);
@@ -6327,7 +8256,7 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
     }
 
     // prepare smoothing-source list from per-chunk smoothing-record lists
-    auto smoothing_src = std::vector<FillSrc<uint32_t>>();
+    auto& smoothing_src = sources.smoothing_src;
     {
         smoothing_src.reserve(list_info.smoothing_offsets_size + 2);
         smoothing_src.push_back({ 0, 0 });
@@ -6359,13 +8288,14 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
                     }
                 }
             } else {
-                return Result{ Attributes{}, Shapes{}, Materials{}, { parsed_materials.error.code } };
+                sources.error = Error{ parsed_materials.error.code };
+                return sources;
             }
         }
     }
 
     // prepare material-source list from per-chunk material-record lists
-    auto material_src = std::vector<FillSrc<int32_t>>();
+    auto& material_src = sources.material_src;
     if (context->material.library) {
         material_src.reserve(list_info.material_offsets_size + 2);
         material_src.push_back({ -1, 0 });
@@ -6384,16 +8314,36 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
                     for (size_t j = 0; j != i; ++j) {
                         line_num += chunks[j].text.line_count;
                     }
-                    auto error = Error{ rapidobj_errc::MaterialNotFoundError, record.line, line_num };
-                    return Result{ Attributes{}, Shapes{}, Materials{}, std::move(error) };
+                    sources.error = Error{ rapidobj_errc::MaterialNotFoundError, record.line, line_num };
+                    return sources;
                 }
             }
         }
         material_src.push_back({ -1, list_info.face_buffers_size });
     }
 
+    sources.materials = std::move(parsed_materials.materials);
+
+    return sources;
+}
+
+inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedContext> context)
+{
+    auto sources = PrepareMerge(chunks, context.get());
+
+    if (sources.error) {
+        return Result{ Attributes{}, Shapes{}, Materials{}, std::move(sources.error) };
+    }
+
+    const auto& offsets       = sources.offsets;
+    const auto& count         = sources.count;
+    auto&       shape_records = sources.shape_records;
+    const auto& smoothing_src = sources.smoothing_src;
+    const auto& material_src  = sources.material_src;
+
+    auto state  = context->parsing.retained;
     auto shapes = Shapes();
-    auto tasks  = MergeTasks();
+    auto tasks  = TakeMergeTasks(state ? &state->merge_tasks : nullptr);
 
     shapes.reserve(shape_records.size());
 
@@ -6402,6 +8352,11 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
         auto& shape = shape_records[i];
         auto& next  = shape_records[i + 1];
 
+        // skip shape rejected by the shape filter, along with its elements stored by the chunks that follow
+        if (shape.skipped) {
+            continue;
+        }
+
         // compute shape info
         auto shape_info = ShapeInfo{};
 
@@ -6448,16 +8403,18 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
         auto num_faces         = shape_info.mesh.faces_array_size;
         auto num_material_ids  = context->material.library ? num_faces : 0;
         auto num_smoothing_ids = num_faces;
+        auto resource          = context->merging.resource;
 
         // allocate Shape
         shapes.push_back(Shape{
             std::move(shape.name),
-            Mesh{ Array<Index>(num_indices),
-                  Array<uint8_t>(num_faces),
-                  Array<int32_t>(num_material_ids),
-                  Array<uint32_t>(num_smoothing_ids) },
-            Lines{ Array<Index>(shape_info.line.index_array_size), Array<int32_t>(shape_info.line.segment_array_size) },
-            Points{ Array<Index>(shape_info.point.index_array_size) } });
+            Mesh{ Array<Index>(num_indices, resource),
+                  Array<uint8_t>(num_faces, resource),
+                  Array<int32_t>(num_material_ids, resource),
+                  Array<uint32_t>(num_smoothing_ids, resource) },
+            Lines{ Array<Index>(shape_info.line.index_array_size, resource),
+                   Array<int32_t>(shape_info.line.segment_array_size, resource) },
+            Points{ Array<Index>(shape_info.point.index_array_size, resource) } });
 
         // compute tasks to construct shape mesh
         if (shape_info.mesh.index_array_size) {
@@ -6468,19 +8425,19 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
 
                 for (size_t j = shape.chunk_index; j <= next.chunk_index; ++j) {
                     auto index_src   = chunks[j].mesh.indices.buffer.data();
-                    auto index_flags = chunks[j].mesh.indices.flags.data();
+                    auto index_flags = OffsetFlagsAt(chunks[j].mesh.indices.flags, 0);
                     auto index_size  = chunks[j].mesh.indices.buffer.size();
                     auto nface_src   = chunks[j].mesh.faces.buffer.data();
                     auto nface_size  = chunks[j].mesh.faces.buffer.size();
                     if (shape.chunk_index == next.chunk_index) {
                         index_src   = index_src + shape.mesh.index_buffer_start;
-                        index_flags = index_flags + shape.mesh.index_buffer_start;
+                        index_flags = OffsetFlagsAt(chunks[j].mesh.indices.flags, shape.mesh.index_buffer_start);
                         index_size  = next.mesh.index_buffer_start - shape.mesh.index_buffer_start;
                         nface_src   = nface_src + shape.mesh.face_buffer_start;
                         nface_size  = next.mesh.face_buffer_start - shape.mesh.face_buffer_start;
                     } else if (j == shape.chunk_index) {
                         index_src   = index_src + shape.mesh.index_buffer_start;
-                        index_flags = index_flags + shape.mesh.index_buffer_start;
+                        index_flags = OffsetFlagsAt(chunks[j].mesh.indices.flags, shape.mesh.index_buffer_start);
                         index_size  = index_size - shape.mesh.index_buffer_start;
                         nface_src   = nface_src + shape.mesh.face_buffer_start;
                         nface_size  = nface_size - shape.mesh.face_buffer_start;
@@ -6522,19 +8479,19 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
 
             for (size_t j = shape.chunk_index; j <= next.chunk_index; ++j) {
                 auto index_src   = chunks[j].lines.indices.buffer.data();
-                auto index_flags = chunks[j].lines.indices.flags.data();
+                auto index_flags = OffsetFlagsAt(chunks[j].lines.indices.flags, 0);
                 auto index_size  = chunks[j].lines.indices.buffer.size();
                 auto nline_src   = chunks[j].lines.segments.buffer.data();
                 auto nline_size  = chunks[j].lines.segments.buffer.size();
                 if (shape.chunk_index == next.chunk_index) {
                     index_src   = index_src + shape.lines.index_buffer_start;
-                    index_flags = index_flags + shape.lines.index_buffer_start;
+                    index_flags = OffsetFlagsAt(chunks[j].lines.indices.flags, shape.lines.index_buffer_start);
                     index_size  = next.lines.index_buffer_start - shape.lines.index_buffer_start;
                     nline_src   = nline_src + shape.lines.segment_buffer_start;
                     nline_size  = next.lines.segment_buffer_start - shape.lines.segment_buffer_start;
                 } else if (j == shape.chunk_index) {
                     index_src   = index_src + shape.lines.index_buffer_start;
-                    index_flags = index_flags + shape.lines.index_buffer_start;
+                    index_flags = OffsetFlagsAt(chunks[j].lines.indices.flags, shape.lines.index_buffer_start);
                     index_size  = index_size - shape.lines.index_buffer_start;
                     nline_src   = nline_src + shape.lines.segment_buffer_start;
                     nline_size  = nline_size - shape.lines.segment_buffer_start;
@@ -6560,15 +8517,15 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
 
             for (size_t j = shape.chunk_index; j <= next.chunk_index; ++j) {
                 auto index_src   = chunks[j].points.indices.buffer.data();
-                auto index_flags = chunks[j].points.indices.flags.data();
+                auto index_flags = OffsetFlagsAt(chunks[j].points.indices.flags, 0);
                 auto index_size  = chunks[j].points.indices.buffer.size();
                 if (shape.chunk_index == next.chunk_index) {
                     index_src   = index_src + shape.points.index_buffer_start;
-                    index_flags = index_flags + shape.points.index_buffer_start;
+                    index_flags = OffsetFlagsAt(chunks[j].points.indices.flags, shape.points.index_buffer_start);
                     index_size  = next.points.index_buffer_start - shape.points.index_buffer_start;
                 } else if (j == shape.chunk_index) {
                     index_src   = index_src + shape.points.index_buffer_start;
-                    index_flags = index_flags + shape.points.index_buffer_start;
+                    index_flags = OffsetFlagsAt(chunks[j].points.indices.flags, shape.points.index_buffer_start);
                     index_size  = index_size - shape.points.index_buffer_start;
                 } else if (j == next.chunk_index) {
                     index_size = next.points.index_buffer_start;
@@ -6594,10 +8551,11 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
     auto attribute_size_color = has_vertex_colors ? attribute_size.position : size_t{};
 
     // allocate attribute arrays
-    auto attributes = Attributes{ { attribute_size.position },
-                                  { attribute_size.texcoord },
-                                  { attribute_size.normal },
-                                  { attribute_size_color } };
+    auto resource   = context->merging.resource;
+    auto attributes = Attributes{ { attribute_size.position, resource },
+                                  { attribute_size.texcoord, resource },
+                                  { attribute_size.normal, resource },
+                                  { attribute_size_color, resource } };
 
     // compute tasks to construct attribute arrays
     auto positions_destination = attributes.positions.data();
@@ -6649,21 +8607,235 @@ inline Result Merge(const std::vector<Chunk>& chunks, std::shared_ptr<SharedCont
         MergeSequential(&tasks, context);
     }
 
+    if (state) {
+        state->merge_tasks.swap(tasks);
+    }
+
     if (context->merging.error != rapidobj_errc::Success) {
         auto error = make_error_code(context->merging.error);
         return Result{ Attributes{}, Shapes{}, Materials{}, Error{ error } };
     }
 
-    return Result{ std::move(attributes), std::move(shapes), std::move(parsed_materials.materials), Error{} };
+    return Result{ std::move(attributes), std::move(shapes), std::move(sources.materials), Error{} };
+}
+
+// Buffers that the segments of a SegmentedResult point into.
+struct SegmentedStorage final {
+    std::vector<Chunk>         chunks;
+    std::vector<Buffer<float>> colors; // default colors for chunks without vertex colors
+};
+
+// Appends the parts of a buffer that belong to a shape, which starts in chunk first and ends in chunk last.
+template <typename T, typename GetBuffer>
+void AppendSegments(
+    Segments<T>*              segments,
+    const std::vector<Chunk>& chunks,
+    size_t                    first,
+    size_t                    begin,
+    size_t                    last,
+    size_t                    end,
+    GetBuffer                 get_buffer)
+{
+    for (size_t j = first; j <= last; ++j) {
+        const auto& buffer = get_buffer(chunks[j]);
+        auto        from   = j == first ? begin : size_t{};
+        auto        to     = j == last ? end : buffer.size();
+        if (to > from) {
+            segments->emplace_back(buffer.data() + from, to - from);
+        }
+    }
+}
+
+template <typename T>
+size_t TotalSize(const Segments<T>& segments) noexcept
+{
+    auto size = size_t{};
+    for (const auto& segment : segments) {
+        size += segment.size();
+    }
+    return size;
+}
+
+// Same as Merge, but instead of copying the chunks into new arrays, the chunks are moved into the result. Indices are
+// rebased in place; only the per-face material and smoothing group ids are written to new arrays.
+inline SegmentedResult MergeSegmented(std::vector<Chunk>* parsed_chunks, std::shared_ptr<SharedContext> context)
+{
+    auto storage = std::make_shared<SegmentedStorage>();
+
+    storage->chunks = std::move(*parsed_chunks);
+
+    auto& chunks  = storage->chunks;
+    auto  sources = PrepareMerge(chunks, context.get());
+
+    if (sources.error) {
+        return SegmentedResult{ SegmentedAttributes{}, SegmentedShapes{}, Materials{}, std::move(sources.error) };
+    }
+
+    const auto& offsets       = sources.offsets;
+    const auto& count         = sources.count;
+    const auto& shape_records = sources.shape_records;
+    const auto& smoothing_src = sources.smoothing_src;
+    const auto& material_src  = sources.material_src;
+
+    auto state = context->parsing.retained;
+    auto tasks = TakeMergeTasks(state ? &state->merge_tasks : nullptr);
+
+    // rebase relative indices in place and check that all indices are in range
+    for (size_t j = 0; j != chunks.size(); ++j) {
+        auto offset = AttributeInfo{ offsets[j].position, offsets[j].texcoord, offsets[j].normal };
+        auto rebase = [&](auto& indices) {
+            if (auto size = indices.buffer.size()) {
+                auto data = indices.buffer.data();
+                tasks.push_back(CopyIndices(data, data, OffsetFlagsAt(indices.flags, 0), size, offset, count));
+            }
+        };
+        rebase(chunks[j].mesh.indices);
+        rebase(chunks[j].lines.indices);
+        rebase(chunks[j].points.indices);
+    }
+
+    auto shapes = SegmentedShapes();
+
+    shapes.reserve(shape_records.size());
+
+    for (size_t i = 0; i != shape_records.size() - 1; ++i) {
+        const auto& shape = shape_records[i];
+        const auto& next  = shape_records[i + 1];
+
+        if (shape.skipped) {
+            continue;
+        }
+
+        auto first = shape.chunk_index;
+        auto last  = next.chunk_index;
+
+        auto segmented = SegmentedShape{ shape.name, {}, {}, {} };
+
+        AppendSegments(
+            &segmented.mesh.indices,
+            chunks,
+            first,
+            shape.mesh.index_buffer_start,
+            last,
+            next.mesh.index_buffer_start,
+            [](const Chunk& chunk) -> auto& { return chunk.mesh.indices.buffer; });
+        AppendSegments(
+            &segmented.mesh.num_face_vertices,
+            chunks,
+            first,
+            shape.mesh.face_buffer_start,
+            last,
+            next.mesh.face_buffer_start,
+            [](const Chunk& chunk) -> auto& { return chunk.mesh.faces.buffer; });
+        AppendSegments(
+            &segmented.lines.indices,
+            chunks,
+            first,
+            shape.lines.index_buffer_start,
+            last,
+            next.lines.index_buffer_start,
+            [](const Chunk& chunk) -> auto& { return chunk.lines.indices.buffer; });
+        AppendSegments(
+            &segmented.lines.num_line_vertices,
+            chunks,
+            first,
+            shape.lines.segment_buffer_start,
+            last,
+            next.lines.segment_buffer_start,
+            [](const Chunk& chunk) -> auto& { return chunk.lines.segments.buffer; });
+        AppendSegments(
+            &segmented.points.indices,
+            chunks,
+            first,
+            shape.points.index_buffer_start,
+            last,
+            next.points.index_buffer_start,
+            [](const Chunk& chunk) -> auto& { return chunk.points.indices.buffer; });
+
+        // skip empty shape
+        if (segmented.mesh.indices.empty() && segmented.lines.indices.empty() && segmented.points.indices.empty()) {
+            continue;
+        }
+
+        // material and smoothing group ids are not stored per face while parsing, so they still need to be filled
+        if (auto num_faces = TotalSize(segmented.mesh.num_face_vertices)) {
+            auto& mesh  = segmented.mesh;
+            auto  start = shape.mesh.face_buffer_start + offsets[shape.chunk_index].face;
+
+            mesh.smoothing_group_ids = Array<uint32_t>(num_faces, context->merging.resource);
+            tasks.push_back(FillSmoothingGroupIds(mesh.smoothing_group_ids.data(), smoothing_src, num_faces, start));
+
+            if (context->material.library) {
+                mesh.material_ids = Array<int32_t>(num_faces, context->merging.resource);
+                if (!material_src.empty()) {
+                    tasks.push_back(FillMaterialIds(mesh.material_ids.data(), material_src, num_faces, start));
+                }
+            }
+        }
+
+        shapes.push_back(std::move(segmented));
+    }
+
+    // attributes are used as they are, except that chunks without vertex colors get default colors if others have them
+    auto attributes        = SegmentedAttributes{};
+    bool has_vertex_colors = false;
+
+    for (const Chunk& chunk : chunks) {
+        has_vertex_colors |= chunk.colors.count ? true : false;
+    }
+
+    for (const Chunk& chunk : chunks) {
+        if (auto size = chunk.positions.buffer.size()) {
+            attributes.positions.emplace_back(chunk.positions.buffer.data(), size);
+        }
+        if (auto size = chunk.texcoords.buffer.size()) {
+            attributes.texcoords.emplace_back(chunk.texcoords.buffer.data(), size);
+        }
+        if (auto size = chunk.normals.buffer.size()) {
+            attributes.normals.emplace_back(chunk.normals.buffer.data(), size);
+        }
+        if (auto size = chunk.colors.buffer.size()) {
+            attributes.colors.emplace_back(chunk.colors.buffer.data(), size);
+        } else if (has_vertex_colors && chunk.positions.buffer.size()) {
+            auto& colors = storage->colors.emplace_back(chunk.positions.buffer.size());
+            std::fill_n(colors.data(), colors.size(), 1.0f);
+            attributes.colors.emplace_back(colors.data(), colors.size());
+        }
+    }
+
+    // perform rebasing and id fills
+    if (context->thread.concurrency > 1) {
+        MergeParallel(&tasks, context);
+    } else {
+        MergeSequential(&tasks, context);
+    }
+
+    if (state) {
+        state->merge_tasks.swap(tasks);
+    }
+
+    if (context->merging.error != rapidobj_errc::Success) {
+        auto error = make_error_code(context->merging.error);
+        return SegmentedResult{ SegmentedAttributes{}, SegmentedShapes{}, Materials{}, Error{ error } };
+    }
+
+    auto result = SegmentedResult{ std::move(attributes), std::move(shapes), std::move(sources.materials), Error{} };
+
+    result.storage = std::move(storage);
+
+    return result;
 }
 
-inline auto ParsePosition(std::string_view line, Chunk* chunk)
+inline auto ParsePosition(std::string_view line, Chunk* chunk, bool skip_colors)
 {
     auto [count, remainder] = ParseXReals(line, 3, &chunk->positions.buffer);
     if (count < 3) {
         return rapidobj_errc::ParseError;
     }
     ++chunk->positions.count;
+    if (skip_colors) {
+        return rapidobj_errc::Success;
+    }
     auto [count2, remainder2] = ParseXReals(remainder, 3, &chunk->colors.buffer);
     if (count2 == 0) {
         if (chunk->colors.buffer.size()) {
@@ -6694,9 +8866,40 @@ inline auto ParsePosition(std::string_view line, Chunk* chunk)
     return rapidobj_errc::Success;
 }
 
-inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedContext* context)
+// Parses the indices of a face, line or point element into the chunk's mesh index buffer, which is used as scratch
+// space, and restores the numbering used in the file: ParseFace is given no attribute counts, so relative indices are
+// left negative and only the other indices need to be incremented again.
+inline auto ParseVisitedIndices(
+    std::string_view text,
+    size_t           min_count,
+    size_t           max_count,
+    OffsetFlags      permitted_flags,
+    Chunk*           chunk)
 {
-    const auto text = line;
+    auto indices = &chunk->mesh.indices.buffer;
+    auto flags   = &chunk->mesh.indices.flags;
+
+    indices->clear();
+    flags->clear();
+
+    auto [count, rc] = ParseFace(text, 0, 0, 0, min_count, max_count, permitted_flags, indices, flags);
+
+    for (size_t i = 0; i != count; ++i) {
+        auto& index    = indices->data()[i];
+        auto  relative = flags->size() ? flags->data()[i] : static_cast<OffsetFlags>(ApplyOffset::None);
+
+        index.position_index += !(relative & ApplyOffset::Position);
+        index.texcoord_index += !(relative & ApplyOffset::Texcoord); // -1 (not present) becomes 0
+        index.normal_index += !(relative & ApplyOffset::Normal);
+    }
+
+    return std::make_pair(count, rc);
+}
+
+// Parses a line like ProcessLine does, but hands the element to the chunk's visitor instead of storing it.
+inline rapidobj_errc VisitLine(std::string_view line, Chunk* chunk)
+{
+    auto visitor = chunk->visitor;
 
     TrimLeft(line);
 
@@ -6708,27 +8911,30 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     // process token
     switch (line.front()) {
     case 'v': {
+        float values[6];
         if (StartsWith(line, "v ") || StartsWith(line, "v\t")) {
             line.remove_prefix(2);
-            if (auto rc = ParsePosition(line, chunk); rc != rapidobj_errc::Success) {
-                return rc;
+            auto [count, remainder] = ParseXReals(line, 6, values);
+            TrimLeft(remainder);
+            if ((count != 3 && count != 6) || !remainder.empty()) {
+                return rapidobj_errc::ParseError;
+            }
+            visitor->Position(values[0], values[1], values[2]);
+            if (count == 6) {
+                visitor->Color(values[3], values[4], values[5]);
             }
         } else if (StartsWith(line, "vt ") || StartsWith(line, "vt\t")) {
             line.remove_prefix(3);
-            auto count = ParseReals(line, 3, &chunk->texcoords.buffer);
-            if (count < 2) {
+            if (ParseReals(line, 3, values) < 2) {
                 return rapidobj_errc::ParseError;
-            } else if (count == 3) {
-                chunk->texcoords.buffer.pop_back();
             }
-            ++chunk->texcoords.count;
+            visitor->Texcoord(values[0], values[1]);
         } else if (StartsWith(line, "vn ") || StartsWith(line, "vn\t")) {
             line.remove_prefix(3);
-            auto count = ParseReals(line, 3, &chunk->normals.buffer);
-            if (count < 3) {
+            if (ParseReals(line, 3, values) < 3) {
                 return rapidobj_errc::ParseError;
             }
-            ++chunk->normals.count;
+            visitor->Normal(values[0], values[1], values[2]);
         } else {
             return rapidobj_errc::ParseError;
         }
@@ -6737,22 +8943,13 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     case 'f': {
         if (StartsWith(line, "f ") || StartsWith(line, "f\t")) {
             line.remove_prefix(2);
-            auto [count, rc] = ParseFace(
-                line,
-                chunk->positions.count,
-                chunk->texcoords.count,
-                chunk->normals.count,
-                kMinVerticesInFace,
-                kMaxVerticesInFace,
-                static_cast<OffsetFlags>(ApplyOffset::All),
-                &chunk->mesh.indices.buffer,
-                &chunk->mesh.indices.flags);
+            auto permitted_flags = static_cast<OffsetFlags>(ApplyOffset::All);
+            auto [count, rc] =
+                ParseVisitedIndices(line, kMinVerticesInFace, kMaxVerticesInFace, permitted_flags, chunk);
             if (rc != rapidobj_errc::Success) {
                 return rc;
             }
-            chunk->mesh.faces.buffer.ensure_enough_room_for(1);
-            chunk->mesh.faces.buffer.push_back(static_cast<unsigned char>(count));
-            ++chunk->mesh.faces.count;
+            visitor->Face(chunk->mesh.indices.buffer.data(), count);
         }
         break;
     }
@@ -6761,15 +8958,8 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     case 'o': {
         if (StartsWith(line, "g ") || StartsWith(line, "g\t") || StartsWith(line, "o ") || StartsWith(line, "o\t")) {
             line.remove_prefix(2);
-            auto name = std::string(line);
-            Trim(name);
-            chunk->shapes.list.push_back({});
-            chunk->shapes.list.back().name                       = std::move(name);
-            chunk->shapes.list.back().mesh.index_buffer_start    = chunk->mesh.indices.buffer.size();
-            chunk->shapes.list.back().mesh.face_buffer_start     = chunk->mesh.faces.buffer.size();
-            chunk->shapes.list.back().lines.index_buffer_start   = chunk->lines.indices.buffer.size();
-            chunk->shapes.list.back().lines.segment_buffer_start = chunk->lines.segments.buffer.size();
-            chunk->shapes.list.back().points.index_buffer_start  = chunk->points.indices.buffer.size();
+            Trim(line);
+            visitor->Group(line);
         } else {
             return rapidobj_errc::ParseError;
         }
@@ -6777,25 +8967,9 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     }
     case 'm': {
         if (StartsWith(line, "mtllib ") || StartsWith(line, "mtllib\t")) {
-            if (context->material.library) {
-                line.remove_prefix(7);
-                Trim(line);
-                bool ambiguous_material_library = false;
-                if (context->material.library_name.empty()) {
-                    std::lock_guard lock(context->material.mutex);
-                    if (context->material.library_name.empty()) {
-                        context->material.library_name = line;
-                        context->material.parse_result = std::async(std::launch::async, ParseMaterialLibrary, context);
-                    } else if (context->material.library_name != line) {
-                        ambiguous_material_library = true;
-                    }
-                } else if (context->material.library_name != line) {
-                    ambiguous_material_library = true;
-                }
-                if (ambiguous_material_library) {
-                    return rapidobj_errc::AmbiguousMaterialLibraryError;
-                }
-            }
+            line.remove_prefix(7);
+            Trim(line);
+            visitor->MaterialFile(line);
         } else {
             return rapidobj_errc::ParseError;
         }
@@ -6803,11 +8977,9 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     }
     case 'u': {
         if (StartsWith(line, "usemtl ") || StartsWith(line, "usemtl\t")) {
-            if (context->material.library) {
-                line.remove_prefix(7);
-                chunk->materials.list.push_back(
-                    { std::string(line), std::string(text), chunk->text.line_count, chunk->mesh.faces.buffer.size() });
-            }
+            line.remove_prefix(7);
+            Trim(line);
+            visitor->UseMaterial(line);
         } else {
             return rapidobj_errc::ParseError;
         }
@@ -6817,18 +8989,16 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
         if (StartsWith(line, "s ") || StartsWith(line, "s\t")) {
             line.remove_prefix(2);
             Trim(line);
+            auto value = 0U;
             if (line.empty()) {
                 return rapidobj_errc::ParseError;
-            } else if (line == "off") {
-                chunk->smoothing.list.push_back({ 0, chunk->mesh.faces.buffer.size() });
-            } else {
-                auto value = 0U;
-                auto data  = &line[0];
+            } else if (line != "off") {
+                auto data = &line[0];
                 if (auto [p, e] = std::from_chars(data, data + line.size(), value); e != kSuccess) {
                     return rapidobj_errc::ParseError;
                 }
-                chunk->smoothing.list.push_back({ value, chunk->mesh.faces.buffer.size() });
             }
+            visitor->SmoothingGroup(value);
         } else {
             return rapidobj_errc::ParseError;
         }
@@ -6837,41 +9007,26 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     case 'l': {
         if (StartsWith(line, "l ") || StartsWith(line, "l\t")) {
             line.remove_prefix(2);
-            auto [count, rc] = ParseFace(
-                line,
-                chunk->positions.count,
-                chunk->texcoords.count,
-                chunk->normals.count,
-                kMinVerticesInLine,
-                kMaxVerticesInLine,
-                static_cast<OffsetFlags>(ApplyOffset::Position | ApplyOffset::Texcoord),
-                &chunk->lines.indices.buffer,
-                &chunk->lines.indices.flags);
+            auto permitted_flags = static_cast<OffsetFlags>(ApplyOffset::Position | ApplyOffset::Texcoord);
+            auto [count, rc] =
+                ParseVisitedIndices(line, kMinVerticesInLine, kMaxVerticesInLine, permitted_flags, chunk);
             if (rc != rapidobj_errc::Success) {
                 return rc;
             }
-            chunk->lines.segments.buffer.ensure_enough_room_for(1);
-            chunk->lines.segments.buffer.push_back(static_cast<unsigned char>(count));
-            ++chunk->lines.segments.count;
+            visitor->Line(chunk->mesh.indices.buffer.data(), count);
         }
         break;
     }
     case 'p': {
         if (StartsWith(line, "p ") || StartsWith(line, "p\t")) {
             line.remove_prefix(2);
-            auto [count, rc] = ParseFace(
-                line,
-                chunk->positions.count,
-                chunk->texcoords.count,
-                chunk->normals.count,
-                kMinVerticesInPoint,
-                kMaxVerticesInPoint,
-                static_cast<OffsetFlags>(ApplyOffset::Position),
-                &chunk->points.indices.buffer,
-                &chunk->points.indices.flags);
+            auto permitted_flags = static_cast<OffsetFlags>(ApplyOffset::Position);
+            auto [count, rc] =
+                ParseVisitedIndices(line, kMinVerticesInPoint, kMaxVerticesInPoint, permitted_flags, chunk);
             if (rc != rapidobj_errc::Success) {
                 return rc;
             }
+            visitor->Point(chunk->mesh.indices.buffer.data(), count);
         }
         break;
     }
@@ -6883,811 +9038,2922 @@ inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedCont
     return rapidobj_errc::Success;
 }
 
-inline void ProcessBlocksImpl(
-    Reader*        reader,
-    size_t         block_begin,
-    size_t         block_end,
-    bool           stop_parsing_after_eol,
-    Chunk*         chunk,
-    SharedContext* context)
+// Counts a line by its keyword, for ScanFile. Nothing is stored and, apart from the positions when the bounds are
+// tracked, nothing is parsed; lines with an unknown keyword are not counted.
+inline void ScanLine(std::string_view line, ChunkScan* scan)
 {
-    assert(reader);
-
-    bool begin_parsing_after_eol = block_begin > 0;
-    bool reached_eof             = false;
-
-    auto buffer_size = kMaxLineLength + kBlockSize;
-    auto buffer1     = std::unique_ptr<char, sys::AlignedDeleter>(sys::AlignedAllocate(buffer_size, 4_KiB));
-    auto buffer2     = std::unique_ptr<char, sys::AlignedDeleter>(sys::AlignedAllocate(buffer_size, 4_KiB));
-
-    auto front_buffer = buffer1.get();
-    auto back_buffer  = buffer2.get();
-
-    auto file_offset = block_begin * kBlockSize;
-
-    auto line = std::string_view();
-    auto text = std::string_view();
+    TrimLeft(line);
 
-    if (auto ec = reader->ReadBlock(file_offset, kBlockSize, front_buffer + kMaxLineLength)) {
-        chunk->error = Error{ ec };
+    if (line.size() < 2) {
         return;
     }
 
-    if (auto [bytes_read, ec] = reader->WaitForResult(); ec) {
-        chunk->error = Error{ ec };
-        return;
-    } else {
-        reached_eof = bytes_read < kBlockSize;
-        text        = std::string_view(front_buffer + kMaxLineLength, bytes_read);
-    }
+    auto& result    = scan->result;
+    auto  separator = line[1] == ' ' || line[1] == '\t';
 
-    if (begin_parsing_after_eol) {
-        if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', kMaxLineLength))) {
-            auto pos = static_cast<size_t>(ptr - text.data());
-            text.remove_prefix(pos + 1);
+    switch (line.front()) {
+    case 'v': {
+        if (separator) {
+            ++result.num_positions;
+            if (scan->bounds) {
+                float values[6];
+                line.remove_prefix(2);
+                if (auto [count, remainder] = ParseXReals(line, 6, values); count >= 3) {
+                    for (size_t i = 0; i != 3; ++i) {
+                        result.min[i] = std::min(result.min[i], values[i]);
+                        result.max[i] = std::max(result.max[i], values[i]);
+                    }
+                }
+            }
+        } else if (StartsWith(line, "vt ") || StartsWith(line, "vt\t")) {
+            ++result.num_texcoords;
+        } else if (StartsWith(line, "vn ") || StartsWith(line, "vn\t")) {
+            ++result.num_normals;
+        }
+        break;
+    }
+    case 'f': result.num_faces += separator; break;
+    case 'l': result.num_lines += separator; break;
+    case 'p': result.num_points += separator; break;
+    case 'g':
+    case 'o': result.num_shapes += separator; break;
+    case 'm': {
+        if (result.material_library.empty() && (StartsWith(line, "mtllib ") || StartsWith(line, "mtllib\t"))) {
+            line.remove_prefix(7);
+            Trim(line);
+            result.material_library = line;
+        }
+        break;
+    }
+    default: break;
+    }
+}
+
+// Marks the texcoord and normal components of the last count indices as not present, for the attributes that are not
+// loaded, so that the merge step neither offsets nor bounds checks them.
+inline void DropSkippedIndices(
+    const SharedContext::Parsing& parsing,
+    size_t                        count,
+    Buffer<Index>*                indices,
+    Buffer<OffsetFlags>*          offset_flags) noexcept
+{
+    auto mask = static_cast<OffsetFlags>(ApplyOffset::All);
+
+    if (parsing.skip_texcoords) {
+        mask &= ~static_cast<OffsetFlags>(ApplyOffset::Texcoord);
+    }
+    if (parsing.skip_normals) {
+        mask &= ~static_cast<OffsetFlags>(ApplyOffset::Normal);
+    }
+
+    auto index = indices->data() + indices->size() - count;
+
+    for (size_t i = 0; i != count; ++i, ++index) {
+        index->texcoord_index = parsing.skip_texcoords ? -1 : index->texcoord_index;
+        index->normal_index   = parsing.skip_normals ? -1 : index->normal_index;
+    }
+
+    // once present, offset flags are kept for every index
+    if (offset_flags->size() != 0) {
+        auto flags = offset_flags->data() + offset_flags->size() - count;
+        for (size_t i = 0; i != count; ++i) {
+            flags[i] &= mask;
+        }
+    }
+}
+
+inline rapidobj_errc ProcessLine(std::string_view line, Chunk* chunk, SharedContext* context)
+{
+    if (chunk->visitor) {
+        return VisitLine(line, chunk);
+    }
+
+    if (chunk->scan) {
+        ScanLine(line, chunk->scan);
+        return rapidobj_errc::Success;
+    }
+
+    const auto text = line;
+
+    TrimLeft(line);
+
+    // skip empty lines
+    if (line.empty()) {
+        return rapidobj_errc::Success;
+    }
+
+    // process token
+    switch (line.front()) {
+    case 'v': {
+        if (StartsWith(line, "v ") || StartsWith(line, "v\t")) {
+            line.remove_prefix(2);
+            if (auto rc = ParsePosition(line, chunk, context->parsing.skip_colors); rc != rapidobj_errc::Success) {
+                return rc;
+            }
+        } else if (StartsWith(line, "vt ") || StartsWith(line, "vt\t")) {
+            // only counted, so that texcoord indices keep their values
+            if (context->parsing.skip_texcoords) {
+                ++chunk->texcoords.count;
+                break;
+            }
+            line.remove_prefix(3);
+            auto count = ParseReals(line, 3, &chunk->texcoords.buffer);
+            if (count < 2) {
+                return rapidobj_errc::ParseError;
+            } else if (count == 3) {
+                chunk->texcoords.buffer.pop_back();
+            }
+            ++chunk->texcoords.count;
+        } else if (StartsWith(line, "vn ") || StartsWith(line, "vn\t")) {
+            // only counted, so that normal indices keep their values
+            if (context->parsing.skip_normals) {
+                ++chunk->normals.count;
+                break;
+            }
+            line.remove_prefix(3);
+            auto count = ParseReals(line, 3, &chunk->normals.buffer);
+            if (count < 3) {
+                return rapidobj_errc::ParseError;
+            }
+            ++chunk->normals.count;
         } else {
-            ++chunk->text.line_count;
-            auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
-            chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
-            return;
+            return rapidobj_errc::ParseError;
+        }
+        break;
+    }
+    case 'f': {
+        if (StartsWith(line, "f ") || StartsWith(line, "f\t")) {
+            if (chunk->skip_elements) {
+                break;
+            }
+            line.remove_prefix(2);
+            auto [count, rc] = ParseFace(
+                line,
+                chunk->positions.count,
+                chunk->texcoords.count,
+                chunk->normals.count,
+                kMinVerticesInFace,
+                kMaxVerticesInFace,
+                static_cast<OffsetFlags>(ApplyOffset::All),
+                &chunk->mesh.indices.buffer,
+                chunk->is_first ? nullptr : &chunk->mesh.indices.flags);
+            if (rc != rapidobj_errc::Success) {
+                return rc;
+            }
+            if (context->parsing.skip_texcoords || context->parsing.skip_normals) {
+                DropSkippedIndices(context->parsing, count, &chunk->mesh.indices.buffer, &chunk->mesh.indices.flags);
+            }
+            chunk->mesh.faces.buffer.ensure_enough_room_for(1);
+            chunk->mesh.faces.buffer.push_back(static_cast<unsigned char>(count));
+            ++chunk->mesh.faces.count;
+        }
+        break;
+    }
+    case '#': break; // ignore comments
+    case 'g':
+    case 'o': {
+        if (StartsWith(line, "g ") || StartsWith(line, "g\t") || StartsWith(line, "o ") || StartsWith(line, "o\t")) {
+            line.remove_prefix(2);
+            auto name = std::string(line);
+            Trim(name);
+            chunk->skip_elements = context->parsing.shape_filter && !(*context->parsing.shape_filter)(name);
+            chunk->shapes.list.push_back({});
+            chunk->shapes.list.back().name                       = std::move(name);
+            chunk->shapes.list.back().mesh.index_buffer_start    = chunk->mesh.indices.buffer.size();
+            chunk->shapes.list.back().mesh.face_buffer_start     = chunk->mesh.faces.buffer.size();
+            chunk->shapes.list.back().lines.index_buffer_start   = chunk->lines.indices.buffer.size();
+            chunk->shapes.list.back().lines.segment_buffer_start = chunk->lines.segments.buffer.size();
+            chunk->shapes.list.back().points.index_buffer_start  = chunk->points.indices.buffer.size();
+            chunk->shapes.list.back().skipped                    = chunk->skip_elements;
+        } else {
+            return rapidobj_errc::ParseError;
+        }
+        break;
+    }
+    case 'm': {
+        if (StartsWith(line, "mtllib ") || StartsWith(line, "mtllib\t")) {
+            if (context->material.library) {
+                line.remove_prefix(7);
+                Trim(line);
+                bool ambiguous_material_library = false;
+                if (context->material.library_name.empty()) {
+                    std::lock_guard lock(context->material.mutex);
+                    if (context->material.library_name.empty()) {
+                        context->material.library_name = line;
+                        context->material.parse_result = std::async(std::launch::async, ParseMaterialLibrary, context);
+                    } else if (context->material.library_name != line) {
+                        ambiguous_material_library = true;
+                    }
+                } else if (context->material.library_name != line) {
+                    ambiguous_material_library = true;
+                }
+                if (ambiguous_material_library) {
+                    return rapidobj_errc::AmbiguousMaterialLibraryError;
+                }
+            }
+        } else {
+            return rapidobj_errc::ParseError;
+        }
+        break;
+    }
+    case 'u': {
+        if (StartsWith(line, "usemtl ") || StartsWith(line, "usemtl\t")) {
+            if (context->material.library) {
+                line.remove_prefix(7);
+                chunk->materials.list.push_back(
+                    { std::string(line), std::string(text), chunk->text.line_count, chunk->mesh.faces.buffer.size() });
+            }
+        } else {
+            return rapidobj_errc::ParseError;
+        }
+        break;
+    }
+    case 's': {
+        if (StartsWith(line, "s ") || StartsWith(line, "s\t")) {
+            line.remove_prefix(2);
+            Trim(line);
+            if (line.empty()) {
+                return rapidobj_errc::ParseError;
+            } else if (line == "off") {
+                chunk->smoothing.list.push_back({ 0, chunk->mesh.faces.buffer.size() });
+            } else {
+                auto value = 0U;
+                auto data  = &line[0];
+                if (auto [p, e] = std::from_chars(data, data + line.size(), value); e != kSuccess) {
+                    return rapidobj_errc::ParseError;
+                }
+                chunk->smoothing.list.push_back({ value, chunk->mesh.faces.buffer.size() });
+            }
+        } else {
+            return rapidobj_errc::ParseError;
+        }
+        break;
+    }
+    case 'l': {
+        if (StartsWith(line, "l ") || StartsWith(line, "l\t")) {
+            if (chunk->skip_elements) {
+                break;
+            }
+            line.remove_prefix(2);
+            auto [count, rc] = ParseFace(
+                line,
+                chunk->positions.count,
+                chunk->texcoords.count,
+                chunk->normals.count,
+                kMinVerticesInLine,
+                kMaxVerticesInLine,
+                static_cast<OffsetFlags>(ApplyOffset::Position | ApplyOffset::Texcoord),
+                &chunk->lines.indices.buffer,
+                chunk->is_first ? nullptr : &chunk->lines.indices.flags);
+            if (rc != rapidobj_errc::Success) {
+                return rc;
+            }
+            if (context->parsing.skip_texcoords) {
+                DropSkippedIndices(context->parsing, count, &chunk->lines.indices.buffer, &chunk->lines.indices.flags);
+            }
+            chunk->lines.segments.buffer.ensure_enough_room_for(1);
+            chunk->lines.segments.buffer.push_back(static_cast<unsigned char>(count));
+            ++chunk->lines.segments.count;
+        }
+        break;
+    }
+    case 'p': {
+        if (StartsWith(line, "p ") || StartsWith(line, "p\t")) {
+            if (chunk->skip_elements) {
+                break;
+            }
+            line.remove_prefix(2);
+            auto [count, rc] = ParseFace(
+                line,
+                chunk->positions.count,
+                chunk->texcoords.count,
+                chunk->normals.count,
+                kMinVerticesInPoint,
+                kMaxVerticesInPoint,
+                static_cast<OffsetFlags>(ApplyOffset::Position),
+                &chunk->points.indices.buffer,
+                chunk->is_first ? nullptr : &chunk->points.indices.flags);
+            if (rc != rapidobj_errc::Success) {
+                return rc;
+            }
+        }
+        break;
+    }
+    default: {
+        return rapidobj_errc::ParseError;
+    }
+    }
+
+    return rapidobj_errc::Success;
+}
+
+// Reserves room in the buffers of an empty chunk for text_size bytes of text, extrapolating from the elements found in
+// the sample. The estimates are rounded up a little; a buffer that turns out to be too small simply grows as usual.
+inline void PresizeChunk(std::string_view sample, size_t text_size, Chunk* chunk, const SharedContext::Parsing& parsing)
+{
+    auto positions = size_t{};
+    auto colors    = size_t{};
+    auto texcoords = size_t{};
+    auto normals   = size_t{};
+    auto faces     = size_t{};
+    auto indices   = size_t{};
+    auto relative  = size_t{}; // indices of faces that need offset flags
+    auto newlines  = NewlineIndex();
+    auto remainder = sample;
+
+    auto is_blank = [](char c) { return c == ' ' || c == '\t'; };
+
+    // number of whitespace separated fields, not counting the keyword
+    auto count_fields = [&](std::string_view line) {
+        auto count = size_t{};
+        for (size_t i = 1; i != line.size(); ++i) {
+            count += is_blank(line[i - 1]) && !is_blank(line[i]);
+        }
+        return count;
+    };
+
+    // the last line of the sample may be incomplete, so it is not counted
+    while (auto ptr = newlines.Find(remainder.data(), remainder.size())) {
+        auto line = remainder.substr(0, static_cast<size_t>(ptr - remainder.data()));
+        remainder.remove_prefix(line.size() + 1);
+        TrimLeft(line);
+        if (StartsWith(line, "v ") || StartsWith(line, "v\t")) {
+            ++positions;
+            colors += count_fields(line) >= 6;
+        } else if (StartsWith(line, "vt ") || StartsWith(line, "vt\t")) {
+            ++texcoords;
+        } else if (StartsWith(line, "vn ") || StartsWith(line, "vn\t")) {
+            ++normals;
+        } else if (StartsWith(line, "f ") || StartsWith(line, "f\t")) {
+            auto count = count_fields(line);
+            ++faces;
+            indices += count;
+            if (line.find('-') != std::string_view::npos) {
+                relative += count;
+            }
         }
     }
 
-    for (size_t i = block_begin; i != block_end; ++i) {
-        auto remainder = size_t{};
+    auto sample_size = sample.size() - remainder.size();
+
+    if (sample_size == 0) {
+        return;
+    }
+
+    auto scale    = 1.125 * static_cast<double>(text_size) / static_cast<double>(sample_size);
+    auto estimate = [scale](size_t count) { return static_cast<size_t>(scale * static_cast<double>(count)); };
+
+    if (positions) {
+        chunk->positions.buffer.reserve(3 * estimate(positions));
+    }
+    if (colors && !parsing.skip_colors) {
+        chunk->colors.buffer.reserve(3 * estimate(positions));
+    }
+    if (texcoords && !parsing.skip_texcoords) {
+        chunk->texcoords.buffer.reserve(2 * estimate(texcoords));
+    }
+    if (normals && !parsing.skip_normals) {
+        chunk->normals.buffer.reserve(3 * estimate(normals));
+    }
+    if (faces) {
+        chunk->mesh.indices.buffer.reserve(estimate(indices));
+        chunk->mesh.faces.buffer.reserve(estimate(faces));
+    }
+    if (relative && !chunk->is_first) {
+        chunk->mesh.indices.flags.reserve(estimate(indices));
+    }
+}
+
+inline void ProcessBlocksImpl(
+    Reader*        reader,
+    size_t         block_begin,
+    size_t         block_end,
+    bool           stop_parsing_after_eol,
+    Chunk*         chunk,
+    SharedContext* context)
+{
+    assert(reader);
+
+    bool begin_parsing_after_eol = block_begin > 0;
+    bool reached_eof             = false;
+
+    // a ring of buffers: one being parsed, the rest waiting for read requests in flight
+    auto queue_depth = std::clamp(reader->QueueDepth(), size_t(1), kMaxQueueDepth);
+    auto buffer_size = kMaxLineLength + kBlockSize;
+    auto buffers     = std::vector<char*>();
+
+    // the buffers are handed back (or freed) only after all reads into them have completed
+    struct Storage final {
+        ParserState*               state{};
+        std::vector<AlignedBuffer> buffers{};
+        ~Storage() { ReleaseBlockBuffers(state, &buffers); }
+    } storage{ context->parsing.retained, AcquireBlockBuffers(context->parsing.retained, queue_depth + 1) };
+
+    buffers.reserve(queue_depth + 1);
+
+    for (const auto& buffer : storage.buffers) {
+        buffers.push_back(buffer.get());
+    }
+
+    reader->RegisterBuffers(buffers, buffer_size);
+
+    // wait for outstanding requests before the buffers are released
+    struct PendingReads final {
+        Reader* reader{};
+        size_t  count{};
+        ~PendingReads()
+        {
+            for (; count > 0; --count) {
+                reader->WaitForResult();
+            }
+        }
+    } pending{ reader };
+
+    auto next_block = block_begin;
+
+    auto block_buffer = [&](size_t block) { return buffers[(block - block_begin) % buffers.size()]; };
+
+    // submit read requests for blocks up to (and including) last, keeping at most queue_depth in flight
+    auto submit_reads = [&](size_t last) {
+        auto ec = std::error_code();
+        while (!ec && next_block <= last && next_block < block_end && pending.count < queue_depth) {
+            ec = reader->ReadBlock(next_block * kBlockSize, kBlockSize, block_buffer(next_block) + kMaxLineLength);
+            if (!ec) {
+                ++next_block;
+                ++pending.count;
+            }
+        }
+        return ec;
+    };
+
+    auto wait_for_result = [&]() {
+        --pending.count;
+        return reader->WaitForResult();
+    };
+
+    auto line     = std::string_view();
+    auto text     = std::string_view();
+    auto newlines = NewlineIndex();
+
+    if (auto ec = submit_reads(block_begin + queue_depth - 1)) {
+        chunk->error = Error{ ec };
+        return;
+    }
+
+    if (auto [bytes_read, ec] = wait_for_result(); ec) {
+        chunk->error = Error{ ec };
+        return;
+    } else {
+        reached_eof = bytes_read < kBlockSize;
+        text        = std::string_view(block_buffer(block_begin) + kMaxLineLength, bytes_read);
+    }
+
+    if (begin_parsing_after_eol) {
+        if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', kMaxLineLength))) {
+            auto pos = static_cast<size_t>(ptr - text.data());
+            text.remove_prefix(pos + 1);
+        } else {
+            ++chunk->text.line_count;
+            auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+            chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+            return;
+        }
+    }
+
+    if (context->parsing.presize) {
+        auto num_blocks = block_end - block_begin - stop_parsing_after_eol;
+        PresizeChunk(text, reached_eof ? text.size() : num_blocks * kBlockSize, chunk, context->parsing);
+    }
+
+    for (size_t i = block_begin; i != block_end; ++i) {
+        auto remainder = size_t{};
+
+        bool last_block = (i + 1 == block_end) || reached_eof;
+
+        // buffers are reused, so the index must be rebuilt for each block
+        newlines.Reset();
+
+        if (!last_block) {
+            if (auto ec = submit_reads(i + queue_depth)) {
+                chunk->error = Error{ ec };
+                return;
+            }
+        } else if (stop_parsing_after_eol) {
+            if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', kMaxLineLength))) {
+                auto pos = static_cast<size_t>(ptr - text.data());
+                line     = text.substr(0, pos);
+                if (EndsWith(line, '\r')) {
+                    line.remove_suffix(1);
+                }
+                ++chunk->text.line_count;
+                if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
+                    chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
+                }
+            } else {
+                ++chunk->text.line_count;
+                auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+                chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+            }
+            return;
+        }
+
+        while (!text.empty()) {
+            if (auto ptr = newlines.Find(text.data(), text.size())) {
+                auto pos = static_cast<size_t>(ptr - text.data());
+                ++chunk->text.line_count;
+                if (pos > kMaxLineLength) {
+                    auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+                    chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+                    return;
+                }
+                line = text.substr(0, pos);
+                if (EndsWith(line, '\r')) {
+                    line.remove_suffix(1);
+                }
+                text.remove_prefix(pos + 1);
+            } else {
+                if (text.size() > kMaxLineLength) {
+                    ++chunk->text.line_count;
+                    auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+                    chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+                    return;
+                }
+                if (last_block) {
+                    line = text;
+                    ++chunk->text.line_count;
+                    if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
+                        chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
+                        return;
+                    }
+                } else {
+                    remainder = text.size();
+                    memcpy(block_buffer(i + 1) + kMaxLineLength - remainder, text.data(), remainder);
+                }
+                text = {};
+                break;
+            }
+
+            if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
+                chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
+                return;
+            }
+        }
+
+        if (!last_block) {
+            auto [bytes_read, ec] = wait_for_result();
+            if (ec) {
+                chunk->error = Error{ ec };
+                return;
+            }
+            reached_eof = bytes_read < kBlockSize;
+            text = std::string_view(block_buffer(i + 1) + kMaxLineLength - remainder, bytes_read + remainder);
+        } else if (reached_eof) {
+            break;
+        }
+    }
+}
+
+// Parses text consisting of whole lines; the last line does not need to be terminated by a newline.
+inline void ProcessText(std::string_view text, Chunk* chunk, SharedContext* context)
+{
+    auto line     = std::string_view();
+    auto newlines = NewlineIndex();
+
+    while (!text.empty()) {
+        ++chunk->text.line_count;
+        if (auto ptr = newlines.Find(text.data(), text.size())) {
+            auto pos = static_cast<size_t>(ptr - text.data());
+            if (pos > kMaxLineLength) {
+                auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+                chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+                return;
+            }
+            line = text.substr(0, pos);
+            if (EndsWith(line, '\r')) {
+                line.remove_suffix(1);
+            }
+            text.remove_prefix(pos + 1);
+        } else {
+            if (text.size() > kMaxLineLength) {
+                auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+                chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+                return;
+            }
+            line = text;
+            text = {};
+        }
+
+        if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
+            chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
+            return;
+        }
+    }
+}
+
+// Same as ProcessBlocksImpl, except that lines are parsed directly out of the memory mapped file.
+inline void ProcessMappedBlocksImpl(
+    std::string_view mapping,
+    size_t           block_begin,
+    size_t           block_end,
+    bool             stop_parsing_after_eol,
+    Chunk*           chunk,
+    SharedContext*   context)
+{
+    auto begin = std::min(block_begin * kBlockSize, mapping.size());
+    auto end   = std::min(block_end * kBlockSize, mapping.size());
+
+    bool found_last_eol = true;
+
+    // the last line of this chunk is the first line that ends in the last block
+    if (stop_parsing_after_eol) {
+        auto last = std::min((block_end - 1) * kBlockSize, mapping.size());
+        auto size = std::min(mapping.size() - last, kMaxLineLength);
+        if (auto ptr = static_cast<const char*>(memchr(mapping.data() + last, '\n', size))) {
+            end = static_cast<size_t>(ptr - mapping.data()) + 1;
+        } else {
+            end            = last;
+            found_last_eol = false;
+        }
+    }
+
+    auto text = mapping.substr(begin, end - begin);
+
+    if (block_begin > 0) {
+        if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', std::min(text.size(), kMaxLineLength)))) {
+            auto pos = static_cast<size_t>(ptr - text.data());
+            text.remove_prefix(pos + 1);
+        } else {
+            ++chunk->text.line_count;
+            auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+            chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+            return;
+        }
+    }
+
+    if (context->parsing.presize) {
+        PresizeChunk(text.substr(0, kBlockSize), text.size(), chunk, context->parsing);
+    }
+
+    ProcessText(text, chunk, context);
+
+    if (!chunk->error && !found_last_eol) {
+        ++chunk->text.line_count;
+        auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
+        chunk->error = Error{ ec, std::string(mapping.substr(end), 0, kMaxLineLength), chunk->text.line_count };
+    }
+}
+
+inline void ProcessBlocks(
+    DataSource                     source,
+    size_t                         thread_index,
+    size_t                         block_begin,
+    size_t                         block_end,
+    bool                           stop_parsing_after_eol,
+    Chunk*                         chunk,
+    std::shared_ptr<SharedContext> context)
+{
+    assert(chunk);
+    assert(context);
+    assert(block_begin < block_end);
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    auto reader = std::unique_ptr<Reader>();
+
+    if (!context->io.mapping.empty()) {
+        auto mapping = context->io.mapping;
+        ProcessMappedBlocksImpl(mapping, block_begin, block_end, stop_parsing_after_eol, chunk, context.get());
+    } else if (reader = CreateReader(source, context->io); reader->Error()) {
+        chunk->error = Error{ reader->Error() };
+    } else {
+        ProcessBlocksImpl(reader.get(), block_begin, block_end, stop_parsing_after_eol, chunk, context.get());
+    }
+
+    if (1 == std::atomic_fetch_sub(&context->parsing.thread_count, size_t(1))) {
+        context->parsing.completed.set_value();
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto parse_time = t2 - t1;
+
+    if (reader) {
+        context->debug.io.reader[thread_index]         = reader->Name();
+        context->debug.io.num_requests[thread_index]   = reader->NumRequests();
+        context->debug.io.num_bytes_read[thread_index] = reader->BytesRead();
+        context->debug.io.submit_time[thread_index]    = reader->SubmitTime();
+        context->debug.io.wait_time[thread_index]      = reader->WaitTime();
+    } else {
+        // parsed in place; page faults are accounted for in parse time
+        auto mapped_end = std::min(block_end * kBlockSize, context->io.mapping.size());
+
+        context->debug.io.reader[thread_index]         = "mmap";
+        context->debug.io.num_requests[thread_index]   = static_cast<int>(block_end - block_begin);
+        context->debug.io.num_bytes_read[thread_index] = mapped_end - block_begin * kBlockSize;
+        context->debug.io.submit_time[thread_index]    = {};
+        context->debug.io.wait_time[thread_index]      = {};
+    }
+
+    context->debug.parse.time[thread_index] = parse_time;
+}
+
+inline void ParseFileSequential(sys::File* file, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
+{
+    context->thread.concurrency   = 1;
+    context->parsing.thread_count = 1;
+
+    chunks->resize(1);
+
+    context->debug.io.reader.resize(1);
+    context->debug.io.num_requests.resize(1);
+    context->debug.io.num_bytes_read.resize(1);
+    context->debug.io.submit_time.resize(1);
+    context->debug.io.wait_time.resize(1);
+    context->debug.parse.time.resize(1);
+
+    auto source = DataSource(file);
+
+    auto num_blocks             = file->size() / kBlockSize + (file->size() % kBlockSize != 0);
+    auto stop_parsing_after_eol = false;
+    auto chunk                  = &chunks->front();
+
+    ResetChunk(chunk, context->parsing.resource);
+
+    chunk->is_first = true;
+
+    if (context->parsing.prepare_chunk) {
+        (*context->parsing.prepare_chunk)(0, chunk);
+    }
+
+    ProcessBlocks(source, 0, 0, num_blocks, stop_parsing_after_eol, chunk, context);
+}
+
+inline void ParseFileParallel(sys::File* file, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
+{
+    auto source                = DataSource(file);
+    auto num_blocks            = file->size() / kBlockSize + (file->size() % kBlockSize != 0);
+    auto num_threads           = AvailableThreads(context->thread);
+    auto num_blocks_per_thread = num_blocks / num_threads;
+    auto num_remainder_blocks  = num_blocks - (num_blocks_per_thread * num_threads);
+
+    auto tasks = std::vector<size_t>();
+
+    tasks.reserve(num_threads);
+
+    // allocate blocks to tasks
+    {
+        auto block = size_t{};
+
+        while (block < num_blocks) {
+            tasks.push_back(block);
+            block += num_blocks_per_thread;
+            if (num_remainder_blocks > 0) {
+                ++block;
+                --num_remainder_blocks;
+            }
+        }
+    }
+
+    auto num_tasks = tasks.size();
+
+    chunks->resize(num_tasks);
+
+    context->thread.concurrency   = num_threads;
+    context->parsing.thread_count = num_tasks;
+
+    context->debug.io.reader.resize(num_threads);
+    context->debug.io.num_requests.resize(num_threads);
+    context->debug.io.num_bytes_read.resize(num_threads);
+    context->debug.io.submit_time.resize(num_threads);
+    context->debug.io.wait_time.resize(num_threads);
+    context->debug.parse.time.resize(num_threads);
+
+    for (auto& chunk : *chunks) {
+        ResetChunk(&chunk, context->parsing.resource);
+    }
+
+    // relative indices in the other chunks depend on the attribute counts of the chunks before them
+    chunks->front().is_first = true;
+
+    // chunks are prepared on this thread, in chunk order
+    if (context->parsing.prepare_chunk) {
+        for (size_t i = 0; i != num_tasks; ++i) {
+            (*context->parsing.prepare_chunk)(i, &(*chunks)[i]);
+        }
+    }
+
+    // allocate tasks to threads
+    for (size_t i = 0; i != tasks.size(); ++i) {
+        bool is_last                = i + 1 == tasks.size();
+        auto begin                  = tasks[i];
+        auto end                    = is_last ? num_blocks : (tasks[i + 1] + 1);
+        bool stop_parsing_after_eol = !is_last;
+        auto chunk                  = &(*chunks)[i];
+
+        RunAsync(context->thread, ProcessBlocks, source, i, begin, end, stop_parsing_after_eol, chunk, context);
+    }
+
+    // wait for parsing to finish
+    Wait(context->thread, context->parsing.completed.get_future());
+}
+
+inline Result ParseFileCached(
+    const std::filesystem::path& filepath,
+    const MaterialLibrary&       material_library,
+    const Options&               options);
+
+template <typename ResultType>
+ResultType
+ParseFile(const std::filesystem::path& filepath, const MaterialLibrary& material_library, const Options& options)
+{
+    if (filepath.empty()) {
+        auto error = std::make_error_code(std::errc::invalid_argument);
+        return ResultType{ {}, {}, {}, Error{ error } };
+    }
+
+    if constexpr (std::is_same_v<ResultType, Result>) {
+        if (!options.cache_directory.empty()) {
+            return ParseFileCached(filepath, material_library, options);
+        }
+    }
+
+    auto file = sys::File(filepath, options.direct_io && options.read != Read::MemoryMap);
+
+    if (!file) {
+        return ResultType{ {}, {}, {}, Error{ file.error() } };
+    }
+
+    const auto material_library_value   = &material_library.Value();
+    const auto default_loading_policy   = material_library.Policy().value_or(Load::Mandatory);
+    const auto default_material_library = MaterialLibrary::SearchPath(".", default_loading_policy);
+
+    auto context = std::make_shared<SharedContext>();
+
+    context->thread.pool            = options.thread_pool;
+    context->thread.max_threads     = options.max_threads;
+    context->thread.cpu_affinity    = options.cpu_affinity;
+    context->io.read                = options.read;
+    context->io.queue_depth         = std::clamp(options.queue_depth, size_t(1), kMaxQueueDepth);
+    context->parsing.presize        = options.presize;
+    context->parsing.resource       = options.huge_pages ? HugePageResource::Instance() : nullptr;
+    context->parsing.shape_filter   = options.shape_filter ? &options.shape_filter : nullptr;
+    context->parsing.skip_texcoords = options.skip_texcoords;
+    context->parsing.skip_normals   = options.skip_normals;
+    context->parsing.skip_colors    = options.skip_colors;
+    context->merging.resource       = ResultMemoryResource(options);
+
+    // if the file cannot be mapped, fall back to reading it
+    auto mapping = std::unique_ptr<sys::FileMapping>();
+
+    if (options.read == Read::MemoryMap && file.size() > 0) {
+        if (mapping = std::make_unique<sys::FileMapping>(file, options.populate); *mapping) {
+            context->io.mapping = std::string_view(mapping->data(), mapping->size());
+        }
+    }
+
+    context->material.basepath = filepath.parent_path();
+
+    if (std::get_if<std::nullptr_t>(material_library_value) != nullptr) {
+        context->material.library = nullptr;
+    } else if (std::get_if<std::monostate>(material_library_value) != nullptr) {
+        context->material.library = &default_material_library;
+    } else if (auto* paths = std::get_if<std::vector<std::filesystem::path>>(material_library_value)) {
+        if (paths->empty()) {
+            return ResultType{ {}, {}, {}, Error{ rapidobj_errc::InvalidArgumentsError } };
+        }
+        context->material.library = &material_library;
+    } else if (std::get_if<std::string_view>(material_library_value) != nullptr) {
+        context->material.library = &material_library;
+    } else {
+        return ResultType{ {}, {}, {}, Error{ rapidobj_errc::InternalError } };
+    }
+
+    auto chunks = std::vector<Chunk>();
+    auto lease  = ParserStateLease(options.parser_context);
+
+    if (auto state = lease.get()) {
+        chunks.swap(state->chunks);
+    }
+
+    context->parsing.retained = lease.get();
+
+    auto t1 = std::chrono::steady_clock::now();
+    auto f1 = sys::PageFaultCount();
+
+    if (file.size() <= kSingleThreadCutoff) {
+        ParseFileSequential(&file, &chunks, context);
+    } else {
+        ParseFileParallel(&file, &chunks, context);
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    auto f2 = sys::PageFaultCount();
+
+    context->debug.parse.total_time      = t2 - t1;
+    context->debug.parse.num_page_faults = f2 - f1;
+
+    // check if an error occured
+    size_t running_line_num = size_t{};
+    for (auto& chunk : chunks) {
+        if (chunk.error.code) {
+            chunk.error.line_num += running_line_num;
+            return ResultType{ {}, {}, {}, chunk.error };
+        }
+        running_line_num += chunk.text.line_count;
+    }
+
+    for (const auto& chunk : chunks) {
+        auto [num_reallocations, num_bytes_copied] = CountReallocations(chunk);
+        context->debug.parse.num_reallocations += num_reallocations;
+        context->debug.parse.num_bytes_copied += num_bytes_copied;
+    }
+
+    t1 = std::chrono::steady_clock::now();
+    f1 = sys::PageFaultCount();
+
+    auto result = ResultType{};
+
+    if constexpr (std::is_same_v<ResultType, SegmentedResult>) {
+        result = MergeSegmented(&chunks, context);
+    } else {
+        result = Merge(chunks, context);
+    }
+
+    t2 = std::chrono::steady_clock::now();
+    f2 = sys::PageFaultCount();
+
+    context->debug.merge.total_time      = t2 - t1;
+    context->debug.merge.num_page_faults = f2 - f1;
+
+    // std::cout << DumpDebug(*context);
+
+    // keep the buffers for the next call (a SegmentedResult owns its chunks, so there are none left to keep)
+    if (auto state = lease.get()) {
+        state->chunks = std::move(chunks);
+        return result;
+    }
+
+    auto memory = size_t{ 0 };
+
+    for (const auto& chunk : chunks) {
+        memory += SizeInBytes(chunk);
+    }
+
+    // Free memory on the background thread
+    if (memory > kMemoryRecyclingSize) {
+        DeferredFreeQueue::Instance().Push(std::move(chunks));
+    }
+
+    return result;
+}
+
+// Runs the file through the same block pipeline that ParseFile uses, but without merging the chunks afterwards;
+// prepare_chunk sets up each chunk (with a visitor or a scan) before it is parsed.
+inline Error ParseChunks(
+    const std::filesystem::path&               filepath,
+    const std::function<void(size_t, Chunk*)>& prepare_chunk,
+    const Options&                             options)
+{
+    auto file = sys::File(filepath, options.direct_io && options.read != Read::MemoryMap);
+
+    if (!file) {
+        return Error{ file.error() };
+    }
+
+    auto context = std::make_shared<SharedContext>();
+
+    context->thread.pool           = options.thread_pool;
+    context->thread.max_threads    = options.max_threads;
+    context->thread.cpu_affinity   = options.cpu_affinity;
+    context->io.read               = options.read;
+    context->io.queue_depth        = std::clamp(options.queue_depth, size_t(1), kMaxQueueDepth);
+    context->parsing.prepare_chunk = &prepare_chunk;
+
+    // if the file cannot be mapped, fall back to reading it
+    auto mapping = std::unique_ptr<sys::FileMapping>();
+
+    if (options.read == Read::MemoryMap && file.size() > 0) {
+        if (mapping = std::make_unique<sys::FileMapping>(file, options.populate); *mapping) {
+            context->io.mapping = std::string_view(mapping->data(), mapping->size());
+        }
+    }
+
+    auto chunks = std::vector<Chunk>();
+
+    if (file.size() <= kSingleThreadCutoff) {
+        ParseFileSequential(&file, &chunks, context);
+    } else {
+        ParseFileParallel(&file, &chunks, context);
+    }
+
+    size_t running_line_num = size_t{};
+    for (auto& chunk : chunks) {
+        if (chunk.error.code) {
+            chunk.error.line_num += running_line_num;
+            return chunk.error;
+        }
+        running_line_num += chunk.text.line_count;
+    }
+
+    return Error{};
+}
+
+// Elements go straight from the parsed text to the visitors, so there is nothing to merge; the chunks only hold the
+// indices of the element being visited.
+inline Error VisitFile(
+    const std::filesystem::path&           filepath,
+    const std::function<Visitor*(size_t)>& make_visitor,
+    const Options&                         options)
+{
+    if (filepath.empty() || !make_visitor) {
+        return Error{ std::make_error_code(std::errc::invalid_argument) };
+    }
+
+    auto prepare_chunk = [&make_visitor](size_t index, Chunk* chunk) { chunk->visitor = make_visitor(index); };
+
+    return ParseChunks(filepath, prepare_chunk, options);
+}
+
+// Each chunk counts its own lines; the counts are added up, and the bounds combined, once all chunks are done. The
+// chunk buffers are never written to, so they are never allocated.
+inline ScanResult ScanFile(const std::filesystem::path& filepath, bool compute_bounds, const Options& options)
+{
+    auto result = ScanResult{};
+
+    if (filepath.empty()) {
+        result.error = Error{ std::make_error_code(std::errc::invalid_argument) };
+        return result;
+    }
+
+    auto scans = std::deque<ChunkScan>(); // keeps the scans in place as more are added
+
+    auto prepare_chunk = [&scans, compute_bounds](size_t, Chunk* chunk) {
+        auto& scan = scans.emplace_back();
+
+        scan.bounds     = compute_bounds;
+        scan.result.min = { FLT_MAX, FLT_MAX, FLT_MAX };
+        scan.result.max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        chunk->scan     = &scan;
+    };
+
+    if (result.error = ParseChunks(filepath, prepare_chunk, options); result.error) {
+        return result;
+    }
+
+    result.min = { FLT_MAX, FLT_MAX, FLT_MAX };
+    result.max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (const auto& scan : scans) {
+        const auto& chunk = scan.result;
+
+        result.num_positions += chunk.num_positions;
+        result.num_texcoords += chunk.num_texcoords;
+        result.num_normals += chunk.num_normals;
+        result.num_faces += chunk.num_faces;
+        result.num_lines += chunk.num_lines;
+        result.num_points += chunk.num_points;
+        result.num_shapes += chunk.num_shapes;
+
+        if (result.material_library.empty()) {
+            result.material_library = chunk.material_library;
+        }
+
+        for (size_t i = 0; i != 3; ++i) {
+            result.min[i] = std::min(result.min[i], chunk.min[i]);
+            result.max[i] = std::max(result.max[i], chunk.max[i]);
+        }
+    }
+
+    // the bounds stay empty if no position could be parsed
+    if (!compute_bounds || result.min[0] > result.max[0]) {
+        result.min = {};
+        result.max = {};
+    }
+
+    return result;
+}
+
+// All files are parsed on one thread pool (a temporary one if none was supplied), largest file first. Each file is
+// parsed by its own task; the blocks and merge tasks of large files are submitted to the same pool, so that small
+// files fill in the gaps while large files are parsed in parallel.
+inline std::vector<Result> ParseFiles(
+    const std::vector<std::filesystem::path>& filepaths,
+    const MaterialLibrary&                    material_library,
+    const Options&                            options)
+{
+    auto results = std::vector<Result>(filepaths.size());
+
+    if (filepaths.empty()) {
+        return results;
+    }
+
+    auto thread     = SharedContext::Thread{ 0, options.thread_pool, options.max_threads, options.cpu_affinity };
+    auto local_pool = std::unique_ptr<ThreadPool>();
+
+    if (!thread.pool) {
+        local_pool  = std::make_unique<ThreadPool>(AvailableThreads(thread), options.cpu_affinity);
+        thread.pool = local_pool.get();
+    }
+
+    auto file_options        = options;
+    file_options.thread_pool = thread.pool;
+
+    // schedule large files first
+    auto sizes = std::vector<std::uintmax_t>(filepaths.size());
+    auto order = std::vector<size_t>(filepaths.size());
+
+    for (size_t i = 0; i != filepaths.size(); ++i) {
+        auto ec  = std::error_code();
+        auto sz  = std::filesystem::file_size(filepaths[i], ec);
+        sizes[i] = ec ? 0 : sz;
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t lhs, size_t rhs) { return sizes[lhs] > sizes[rhs]; });
+
+    auto num_tasks = std::atomic_size_t{ filepaths.size() };
+    auto completed = std::promise<void>();
+
+    for (auto index : order) {
+        auto func = [&, index]() {
+            results[index] = detail::ParseFile<Result>(filepaths[index], material_library, file_options);
+
+            if (1 == std::atomic_fetch_sub(&num_tasks, size_t(1))) {
+                completed.set_value();
+            }
+        };
+        RunAsync(thread, func);
+    }
+
+    // wait for all files to be parsed
+    Wait(thread, completed.get_future());
+
+    return results;
+}
+
+inline void ParseStreamSequential(std::istream* is, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
+{
+    context->thread.concurrency   = 1;
+    context->parsing.thread_count = 1;
+
+    chunks->resize(1);
+
+    context->debug.io.reader.resize(1);
+    context->debug.io.num_requests.resize(1);
+    context->debug.io.num_bytes_read.resize(1);
+    context->debug.io.submit_time.resize(1);
+    context->debug.io.wait_time.resize(1);
+    context->debug.parse.time.resize(1);
+
+    auto source                 = DataSource(is);
+    auto num_blocks             = std::numeric_limits<size_t>::max();
+    auto stop_parsing_after_eol = false;
+    auto chunk                  = &chunks->front();
+
+    ResetChunk(chunk, context->parsing.resource);
+
+    chunk->is_first = true;
+
+    ProcessBlocks(source, 0, 0, num_blocks, stop_parsing_after_eol, chunk, context);
+}
+
+struct StreamPipeline final {
+    std::vector<std::unique_ptr<char, sys::AlignedDeleter>> storage{}; // all buffers allocated so far
+    std::vector<char*>                                      buffers{}; // parsed; free to be reused
+    std::atomic_bool                                        failed{};  // a batch failed to parse
+    std::mutex                                              mutex{};   // protects storage and buffers
+    std::condition_variable                                 buffer_ready{};
+};
+
+// Parses a batch of whole lines read from the stream into its own chunk, then returns the buffer to the pipeline.
+inline void ProcessStreamBatch(
+    std::string_view                text,
+    char*                           buffer,
+    Chunk*                          chunk,
+    std::shared_ptr<StreamPipeline> pipeline,
+    std::shared_ptr<SharedContext>  context)
+{
+    ProcessText(text, chunk, context.get());
+
+    if (chunk->error) {
+        pipeline->failed = true;
+    }
+
+    {
+        auto lock = std::lock_guard(pipeline->mutex);
+        pipeline->buffers.push_back(buffer);
+    }
+
+    pipeline->buffer_ready.notify_one();
+}
+
+// The calling thread reads the stream in batches and cuts each batch after its last complete line (the partial
+// line is carried over to the next batch). Each batch is parsed into its own chunk by a thread pool task; if no
+// thread pool was supplied, a temporary one is created.
+inline void ParseStreamParallel(std::istream* is, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
+{
+    auto t1 = std::chrono::steady_clock::now();
+
+    auto num_threads = AvailableThreads(context->thread);
+    auto max_buffers = 2 * num_threads;
+    auto buffer_size = kMaxLineLength + kStreamBatchSize;
+    auto reader      = StreamReader(is);
+    auto pipeline    = std::make_shared<StreamPipeline>();
+    auto parsed      = std::deque<Chunk>(); // elements do not move when a new chunk is added
+    auto carry       = std::array<char, kMaxLineLength>();
+    auto carry_size  = size_t{};
+    auto offset      = size_t{};
+    auto local_pool  = std::unique_ptr<ThreadPool>();
+    auto pool        = context->thread.pool;
+    auto reusable    = std::move(*chunks); // chunks left over from earlier calls, reused before new ones are added
+    auto state       = context->parsing.retained;
+
+    context->thread.concurrency = 1;
+
+    if (state) {
+        while (!state->batch_buffers.empty() && pipeline->storage.size() < max_buffers) {
+            pipeline->storage.push_back(std::move(state->batch_buffers.back()));
+            pipeline->buffers.push_back(pipeline->storage.back().get());
+            state->batch_buffers.pop_back();
+        }
+    }
+
+    context->debug.io.reader.resize(1);
+    context->debug.io.num_requests.resize(1);
+    context->debug.io.num_bytes_read.resize(1);
+    context->debug.io.submit_time.resize(1);
+    context->debug.io.wait_time.resize(1);
+    context->debug.parse.time.resize(1);
+
+    // waits until the predicate is true; pending pool tasks are run while waiting
+    auto wait_until = [&](auto predicate) {
+        auto lock = std::unique_lock(pipeline->mutex);
+        while (!predicate()) {
+            lock.unlock();
+            bool ran = pool && ThreadPoolAccess::RunPendingTask(pool);
+            lock.lock();
+            if (!ran) {
+                pipeline->buffer_ready.wait(lock, predicate);
+            }
+        }
+    };
+
+    auto acquire_buffer = [&]() {
+        wait_until([&] { return !pipeline->buffers.empty() || pipeline->storage.size() < max_buffers; });
+        auto lock = std::lock_guard(pipeline->mutex);
+        if (pipeline->buffers.empty()) {
+            pipeline->storage.emplace_back(sys::AlignedAllocate(buffer_size, 4_KiB));
+            return pipeline->storage.back().get();
+        }
+        auto buffer = pipeline->buffers.back();
+        pipeline->buffers.pop_back();
+        return buffer;
+    };
+
+    auto release_buffer = [&](char* buffer) {
+        auto lock = std::lock_guard(pipeline->mutex);
+        pipeline->buffers.push_back(buffer);
+    };
+
+    if (reader.Error()) {
+        parsed.emplace_back().error = Error{ reader.Error() };
+    }
+
+    while (!reader.Error() && !pipeline->failed) {
+        auto buffer = acquire_buffer();
+        auto data   = buffer + kMaxLineLength;
+
+        memcpy(data - carry_size, carry.data(), carry_size);
+
+        reader.ReadBlock(offset, kStreamBatchSize, data);
+
+        auto [bytes_read, ec] = reader.WaitForResult();
+
+        if (ec) {
+            parsed.emplace_back().error = Error{ ec };
+            release_buffer(buffer);
+            break;
+        }
+
+        offset += bytes_read;
+
+        bool reached_eof = bytes_read < kStreamBatchSize;
+        auto text        = std::string_view(data - carry_size, carry_size + bytes_read);
+
+        carry_size = 0;
+
+        if (!reached_eof) {
+            auto pos = text.rfind('\n');
+            if (pos != std::string_view::npos && text.size() - pos - 1 <= kMaxLineLength) {
+                carry_size = text.size() - pos - 1;
+                memcpy(carry.data(), text.data() + pos + 1, carry_size);
+                text = text.substr(0, pos + 1);
+            } else {
+                // the last line is too long; stop reading and let the parser report the error
+                reached_eof = true;
+            }
+        }
+
+        bool started = context->thread.concurrency > 1;
+
+        if (text.empty() && started) {
+            release_buffer(buffer);
+            break;
+        }
+
+        auto chunk = parsed.size() < reusable.size() ? &parsed.emplace_back(std::move(reusable[parsed.size()]))
+                                                     : &parsed.emplace_back();
+
+        ResetChunk(chunk, context->parsing.resource);
+
+        chunk->is_first = parsed.size() == 1;
+
+        if (reached_eof && !started) {
+            // the whole stream fits into a single batch; parse it on this thread
+            ProcessText(text, chunk, context.get());
+            release_buffer(buffer);
+            break;
+        }
+
+        if (!started) {
+            if (!pool) {
+                local_pool = std::make_unique<ThreadPool>(num_threads, context->thread.cpu_affinity);
+                pool       = local_pool.get();
+            }
+            context->thread.concurrency = num_threads;
+        }
+
+        RunAsync(SharedContext::Thread{ 0, pool }, ProcessStreamBatch, text, buffer, chunk, pipeline, context);
+
+        if (reached_eof) {
+            break;
+        }
+    }
+
+    // wait for parsing to finish
+    wait_until([&] { return pipeline->buffers.size() == pipeline->storage.size(); });
+
+    chunks->assign(std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+
+    if (state) {
+        auto lock = std::lock_guard(pipeline->mutex);
+        std::move(pipeline->storage.begin(), pipeline->storage.end(), std::back_inserter(state->batch_buffers));
+        pipeline->storage.clear();
+        pipeline->buffers.clear();
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+
+    context->debug.io.reader[0]         = reader.Name();
+    context->debug.io.num_requests[0]   = reader.NumRequests();
+    context->debug.io.num_bytes_read[0] = reader.BytesRead();
+    context->debug.io.submit_time[0]    = reader.SubmitTime();
+    context->debug.io.wait_time[0]      = reader.WaitTime();
+    context->debug.parse.time[0]        = t2 - t1;
+}
+
+template <typename ResultType>
+ResultType ParseStream(std::istream& is, const MaterialLibrary& material_library, const Options& options)
+{
+    auto context                  = std::make_shared<SharedContext>();
+    auto chunks                   = std::vector<Chunk>();
+    auto material_library_value   = &material_library.Value();
+    auto default_material_library = MaterialLibrary::SearchPaths({}, Load::Optional);
+
+    if (std::get_if<std::nullptr_t>(material_library_value) != nullptr) {
+        context->material.library = nullptr;
+    } else if (std::get_if<std::monostate>(material_library_value) != nullptr) {
+        if (material_library.Policy()) {
+            return ResultType{ {}, {}, {}, Error{ rapidobj_errc::InvalidArgumentsError } };
+        }
+        context->material.library = &default_material_library;
+    } else if (auto* paths = std::get_if<std::vector<std::filesystem::path>>(material_library_value)) {
+        if (paths->empty()) {
+            return ResultType{ {}, {}, {}, Error{ rapidobj_errc::InvalidArgumentsError } };
+        }
+        if (std::any_of(paths->begin(), paths->end(), [](auto& path) { return path.is_relative(); })) {
+            return ResultType{ {}, {}, {}, Error{ rapidobj_errc::MaterialRelativePathError } };
+        }
+        context->material.library = &material_library;
+    } else if (std::get_if<std::string_view>(material_library_value) != nullptr) {
+        context->material.library = &material_library;
+    } else {
+        return ResultType{ {}, {}, {}, Error{ rapidobj_errc::InternalError } };
+    }
+
+    context->thread.pool            = options.thread_pool;
+    context->thread.max_threads     = options.max_threads;
+    context->thread.cpu_affinity    = options.cpu_affinity;
+    context->parsing.resource       = options.huge_pages ? HugePageResource::Instance() : nullptr;
+    context->parsing.shape_filter   = options.shape_filter ? &options.shape_filter : nullptr;
+    context->parsing.skip_texcoords = options.skip_texcoords;
+    context->parsing.skip_normals   = options.skip_normals;
+    context->parsing.skip_colors    = options.skip_colors;
+    context->merging.resource       = ResultMemoryResource(options);
+
+    auto lease = ParserStateLease(options.parser_context);
+
+    if (auto state = lease.get()) {
+        chunks.swap(state->chunks);
+    }
+
+    context->parsing.retained = lease.get();
+
+    auto t1 = std::chrono::steady_clock::now();
+    auto f1 = sys::PageFaultCount();
+
+    if (AvailableThreads(context->thread) > 1) {
+        ParseStreamParallel(&is, &chunks, context);
+    } else {
+        ParseStreamSequential(&is, &chunks, context);
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    auto f2 = sys::PageFaultCount();
+
+    context->debug.parse.total_time      = t2 - t1;
+    context->debug.parse.num_page_faults = f2 - f1;
+
+    // check if an error occured
+    size_t running_line_num = size_t{};
+    for (auto& chunk : chunks) {
+        if (chunk.error.code) {
+            chunk.error.line_num += running_line_num;
+            return ResultType{ {}, {}, {}, chunk.error };
+        }
+        running_line_num += chunk.text.line_count;
+    }
+
+    for (const auto& chunk : chunks) {
+        auto [num_reallocations, num_bytes_copied] = CountReallocations(chunk);
+        context->debug.parse.num_reallocations += num_reallocations;
+        context->debug.parse.num_bytes_copied += num_bytes_copied;
+    }
+
+    t1 = std::chrono::steady_clock::now();
+    f1 = sys::PageFaultCount();
+
+    auto result = ResultType{};
+
+    if constexpr (std::is_same_v<ResultType, SegmentedResult>) {
+        result = MergeSegmented(&chunks, context);
+    } else {
+        result = Merge(chunks, context);
+    }
+
+    t2 = std::chrono::steady_clock::now();
+    f2 = sys::PageFaultCount();
+
+    context->debug.merge.total_time      = t2 - t1;
+    context->debug.merge.num_page_faults = f2 - f1;
+
+    // std::cout << DumpDebug(*context);
+
+    // keep the buffers for the next call (a SegmentedResult owns its chunks, so there are none left to keep)
+    if (auto state = lease.get()) {
+        state->chunks = std::move(chunks);
+        return result;
+    }
+
+    auto memory = size_t{ 0 };
+
+    for (const auto& chunk : chunks) {
+        memory += SizeInBytes(chunk);
+    }
+
+    // Free memory on the background thread
+    if (memory > kMemoryRecyclingSize) {
+        DeferredFreeQueue::Instance().Push(std::move(chunks));
+    }
+
+    return result;
+}
+
+struct TriangulateTask final {
+    TriangulateTask(
+        const Mesh* src_,
+        Mesh*       dst_,
+        size_t      cost_,
+        size_t      isrc_,
+        size_t      idst_,
+        size_t      fsrc_,
+        size_t      fdst_,
+        size_t      size_) noexcept
+        : src(src_), dst(dst_), cost(cost_), isrc(isrc_), idst(idst_), fsrc(fsrc_), fdst(fdst_), size(size_)
+    {}
+
+    const Mesh* src{};
+    Mesh*       dst{};
+    size_t      cost{};
+    size_t      isrc{};
+    size_t      idst{};
+    size_t      fsrc{};
+    size_t      fdst{};
+    size_t      size{};
+};
+
+inline auto CalculatePolygonArea(float* x, float* y, size_t size) noexcept
+{
+    auto area = 0.0f;
+
+    for (size_t i = 1; i != size; ++i) {
+        auto avg_height = (y[i - 1] + y[i]) / 2;
+        auto width      = x[i] - x[i - 1];
+        area += width * avg_height;
+    }
+
+    auto avg_height = (y[0] + y[size - 1]) / 2;
+    auto width      = x[0] - x[size - 1];
+    area += width * avg_height;
 
-        bool last_block = (i + 1 == block_end) || reached_eof;
+    return std::abs(area);
+}
 
-        if (!last_block) {
-            file_offset = (i + 1) * kBlockSize;
+enum class ProjectionPlane { X, Y, Z };
 
-            if (auto ec = reader->ReadBlock(file_offset, kBlockSize, back_buffer + kMaxLineLength)) {
-                chunk->error = Error{ ec };
-                return;
+inline bool TriangulateSingleTask(const Array<float>& positions, const TriangulateTask& task)
+{
+    auto [src, dst, cost, isrc, idst, fsrc, fdst, size] = task;
+
+    auto  complex   = std::array<std::vector<std::array<float, 2>>, 1>();
+    auto& polygon   = complex.front();
+    auto  index_map = std::vector<size_t>();
+
+    for (size_t i = 0; i != size; ++i) {
+        auto num_vertices = src->num_face_vertices[fsrc + i];
+        auto material_id  = src->material_ids[fsrc + i];
+        auto smoothing_id = src->smoothing_group_ids[fsrc + i];
+
+        if (num_vertices == 3) {
+            dst->indices[idst + 0] = src->indices[isrc + 0];
+            dst->indices[idst + 1] = src->indices[isrc + 1];
+            dst->indices[idst + 2] = src->indices[isrc + 2];
+
+            isrc += 3;
+            idst += 3;
+
+            dst->num_face_vertices[fdst]   = 3;
+            dst->material_ids[fdst]        = material_id;
+            dst->smoothing_group_ids[fdst] = smoothing_id;
+
+            fdst++;
+
+        } else if (num_vertices == 4) {
+            const auto& index0 = src->indices[isrc + 0];
+            const auto& index1 = src->indices[isrc + 1];
+            const auto& index2 = src->indices[isrc + 2];
+            const auto& index3 = src->indices[isrc + 3];
+
+            isrc += 4;
+
+            bool d02_is_less{};
+            {
+                auto position_index0 = 3 * static_cast<size_t>(index0.position_index);
+                auto position_index1 = 3 * static_cast<size_t>(index1.position_index);
+                auto position_index2 = 3 * static_cast<size_t>(index2.position_index);
+                auto position_index3 = 3 * static_cast<size_t>(index3.position_index);
+
+                auto pos0_x = positions[position_index0 + 0];
+                auto pos0_y = positions[position_index0 + 1];
+                auto pos0_z = positions[position_index0 + 2];
+
+                auto pos1_x = positions[position_index1 + 0];
+                auto pos1_y = positions[position_index1 + 1];
+                auto pos1_z = positions[position_index1 + 2];
+
+                auto pos2_x = positions[position_index2 + 0];
+                auto pos2_y = positions[position_index2 + 1];
+                auto pos2_z = positions[position_index2 + 2];
+
+                auto pos3_x = positions[position_index3 + 0];
+                auto pos3_y = positions[position_index3 + 1];
+                auto pos3_z = positions[position_index3 + 2];
+
+                auto e02_x = pos0_x - pos2_x;
+                auto e02_y = pos0_y - pos2_y;
+                auto e02_z = pos0_z - pos2_z;
+
+                auto e13_x = pos1_x - pos3_x;
+                auto e13_y = pos1_y - pos3_y;
+                auto e13_z = pos1_z - pos3_z;
+
+                auto d02 = e02_x * e02_x + e02_y * e02_y + e02_z * e02_z;
+                auto d13 = e13_x * e13_x + e13_y * e13_y + e13_z * e13_z;
+
+                d02_is_less = d02 < d13;
             }
 
-        } else if (stop_parsing_after_eol) {
-            if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', kMaxLineLength))) {
-                auto pos = static_cast<size_t>(ptr - text.data());
-                line     = text.substr(0, pos);
-                if (EndsWith(line, '\r')) {
-                    line.remove_suffix(1);
-                }
-                ++chunk->text.line_count;
-                if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
-                    chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
-                }
+            dst->indices[idst + 0] = index0;
+            dst->indices[idst + 1] = index1;
+            dst->indices[idst + 2] = d02_is_less ? index2 : index3;
+            dst->indices[idst + 3] = d02_is_less ? index0 : index1;
+            dst->indices[idst + 4] = index2;
+            dst->indices[idst + 5] = index3;
+
+            idst += 6;
+
+            dst->num_face_vertices[fdst + 0]   = 3;
+            dst->num_face_vertices[fdst + 1]   = 3;
+            dst->material_ids[fdst + 0]        = material_id;
+            dst->material_ids[fdst + 1]        = material_id;
+            dst->smoothing_group_ids[fdst + 0] = smoothing_id;
+            dst->smoothing_group_ids[fdst + 1] = smoothing_id;
+
+            fdst += 2;
+        } else {
+            auto xs = std::array<float, kMaxVerticesInFace>();
+            auto ys = std::array<float, kMaxVerticesInFace>();
+            auto zs = std::array<float, kMaxVerticesInFace>();
+
+            polygon.clear();
+            index_map.clear();
+
+            for (size_t k = 0; k != num_vertices; ++k) {
+                auto position_index = 3 * static_cast<size_t>(src->indices[isrc + k].position_index);
+                index_map.push_back(isrc + k);
+                xs[k] = positions[position_index + 0];
+                ys[k] = positions[position_index + 1];
+                zs[k] = positions[position_index + 2];
+            }
+
+            isrc += num_vertices;
+
+            auto area_x = CalculatePolygonArea(ys.data(), zs.data(), num_vertices);
+            auto area_y = CalculatePolygonArea(xs.data(), zs.data(), num_vertices);
+            auto area_z = CalculatePolygonArea(xs.data(), ys.data(), num_vertices);
+
+            if (FLT_MIN > std::max({ area_x, area_y, area_z })) {
+                return false;
+            }
+
+            auto proj_plane = ProjectionPlane{};
+
+            if (area_x > area_y) {
+                proj_plane = area_x > area_z ? ProjectionPlane::X : ProjectionPlane::Z;
             } else {
-                ++chunk->text.line_count;
-                auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
-                chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
+                proj_plane = area_y > area_z ? ProjectionPlane::Y : ProjectionPlane::Z;
             }
-            return;
-        }
 
-        while (!text.empty()) {
-            if (auto ptr = static_cast<const char*>(memchr(text.data(), '\n', text.size()))) {
-                auto pos = static_cast<size_t>(ptr - text.data());
-                ++chunk->text.line_count;
-                if (pos > kMaxLineLength) {
-                    auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
-                    chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
-                    return;
+            if (proj_plane == ProjectionPlane::X) {
+                for (size_t k = 0; k != num_vertices; ++k) {
+                    polygon.push_back({ ys[k], zs[k] });
                 }
-                line = text.substr(0, pos);
-                if (EndsWith(line, '\r')) {
-                    line.remove_suffix(1);
+            } else if (proj_plane == ProjectionPlane::Y) {
+                for (size_t k = 0; k != num_vertices; ++k) {
+                    polygon.push_back({ xs[k], zs[k] });
                 }
-                text.remove_prefix(pos + 1);
             } else {
-                if (text.size() > kMaxLineLength) {
-                    ++chunk->text.line_count;
-                    auto ec      = make_error_code(rapidobj_errc::LineTooLongError);
-                    chunk->error = Error{ ec, std::string(text, 0, kMaxLineLength), chunk->text.line_count };
-                    return;
-                }
-                if (last_block) {
-                    line = text;
-                    ++chunk->text.line_count;
-                    if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
-                        chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
-                        return;
-                    }
-                } else {
-                    remainder = text.size();
-                    memcpy(back_buffer + kMaxLineLength - remainder, text.data(), remainder);
+                for (size_t k = 0; k != num_vertices; ++k) {
+                    polygon.push_back({ xs[k], ys[k] });
                 }
-                text = {};
-                break;
             }
 
-            if (auto rc = ProcessLine(line, chunk, context); rc != rapidobj_errc::Success) {
-                chunk->error = Error{ make_error_code(rc), std::string(line), chunk->text.line_count };
-                return;
+            auto result = mapbox::earcut(complex);
+
+            if (result.empty() || result.size() % 3 != 0) {
+                return false;
+            }
+
+            for (size_t k = 0; k < result.size(); k += 3) {
+                std::swap(result[k], result[k + 1]);
+            }
+
+            for (size_t k = 0; k != result.size(); ++k) {
+                dst->indices[idst + k] = src->indices[index_map[result[k]]];
+            }
+
+            idst += result.size();
+
+            auto num_triangles = result.size() / 3;
+
+            for (size_t k = 0; k != num_triangles; ++k) {
+                dst->num_face_vertices[fdst + k]   = 3;
+                dst->material_ids[fdst + k]        = material_id;
+                dst->smoothing_group_ids[fdst + k] = smoothing_id;
+            }
+
+            fdst += num_triangles;
+        }
+    }
+    return true;
+}
+
+inline bool TriangulateTasksParallel(
+    const SharedContext::Thread&        thread,
+    size_t                              concurrency,
+    const Array<float>&                 positions,
+    const std::vector<TriangulateTask>& tasks)
+{
+    auto task_index  = std::atomic_size_t{ 0 };
+    auto num_threads = std::atomic_size_t{ concurrency };
+    auto completed   = std::promise<void>();
+    auto success     = std::atomic_bool{ true };
+
+    auto func = [&]() {
+        auto fetched_index = std::atomic_fetch_add(&task_index, size_t(1));
+
+        while (fetched_index < tasks.size()) {
+            if (false == TriangulateSingleTask(positions, tasks[fetched_index])) {
+                success = false;
+                break;
             }
+            fetched_index = std::atomic_fetch_add(&task_index, size_t(1));
         }
 
-        if (!last_block) {
-            auto [bytes_read, ec] = reader->WaitForResult();
-            if (ec) {
-                chunk->error = Error{ ec };
-                return;
-            }
-            reached_eof = bytes_read < kBlockSize;
-            std::swap(front_buffer, back_buffer);
-            text = std::string_view(front_buffer + kMaxLineLength - remainder, bytes_read + remainder);
-        } else if (reached_eof) {
-            break;
+        if (1 == std::atomic_fetch_sub(&num_threads, size_t(1))) {
+            completed.set_value();
         }
+    };
+
+    for (size_t i = 0; i != concurrency; ++i) {
+        RunAsync(thread, func);
     }
+
+    // wait for triangulation to finish
+    Wait(thread, completed.get_future());
+
+    return success;
 }
 
-inline void ProcessBlocks(
-    DataSource                     source,
-    size_t                         thread_index,
-    size_t                         block_begin,
-    size_t                         block_end,
-    bool                           stop_parsing_after_eol,
-    Chunk*                         chunk,
-    std::shared_ptr<SharedContext> context)
+inline bool TriangulateTasksSequential(const Array<float>& positions, const std::vector<TriangulateTask>& tasks)
 {
-    assert(chunk);
-    assert(context);
-    assert(block_begin < block_end);
+    for (const auto& task : tasks) {
+        bool success = TriangulateSingleTask(positions, task);
+        if (!success) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    auto t1 = std::chrono::steady_clock::now();
+inline bool Triangulate(Result& result, const Options& options)
+{
+    auto mesh_tasks = std::vector<TriangulateTask>();
+    auto tasks      = std::vector<TriangulateTask>();
+    auto meshes     = std::vector<Mesh>(result.shapes.size());
+    auto resource   = ResultMemoryResource(options);
 
-    auto reader = CreateReader(source);
+    tasks.reserve(result.shapes.size());
 
-    if (reader->Error()) {
-        chunk->error = Error{ reader->Error() };
-    } else {
-        ProcessBlocksImpl(reader.get(), block_begin, block_end, stop_parsing_after_eol, chunk, context.get());
-    }
+    for (size_t i = 0; i != result.shapes.size(); ++i) {
+        const auto& mesh = result.shapes[i].mesh;
 
-    if (1 == std::atomic_fetch_sub(&context->parsing.thread_count, size_t(1))) {
-        context->parsing.completed.set_value();
-    }
+        mesh_tasks.clear();
 
-    auto t2 = std::chrono::steady_clock::now();
+        auto cost = size_t{ 0 };
 
-    auto parse_time = t2 - t1;
+        auto isrc_begin = size_t{ 0 };
+        auto isrc_end   = size_t{ 0 };
+        auto idst_begin = size_t{ 0 };
+        auto idst_end   = size_t{ 0 };
 
-    context->debug.io.num_requests[thread_index]  = reader->NumRequests();
-    context->debug.io.num_bytes_read[thread_index] = reader->BytesRead();
-    context->debug.io.submit_time[thread_index] = reader->SubmitTime();
-    context->debug.io.wait_time[thread_index]   = reader->WaitTime();
-    context->debug.parse.time[thread_index]     = parse_time;
-}
+        auto fsrc_begin = size_t{ 0 };
+        auto fsrc_end   = size_t{ 0 };
+        auto fdst_begin = size_t{ 0 };
+        auto fdst_end   = size_t{ 0 };
 
-inline void ParseFileSequential(sys::File* file, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
-{
-    context->thread.concurrency   = 1;
-    context->parsing.thread_count = 1;
+        auto triangle_sum = size_t{ 0 };
 
-    chunks->resize(1);
+        for (auto num_vertices : mesh.num_face_vertices) {
+            auto num_triangles = static_cast<size_t>(num_vertices - 2);
 
-    context->debug.io.num_requests.resize(1);
-    context->debug.io.num_bytes_read.resize(1);
-    context->debug.io.submit_time.resize(1);
-    context->debug.io.wait_time.resize(1);
-    context->debug.parse.time.resize(1);
+            triangle_sum += num_triangles;
 
-    auto source = DataSource(file);
+            if (num_vertices == 3) {
+                cost += kTriangulateTriangleCost;
+            } else if (num_vertices == 4) {
+                cost += kTriangulateQuadCost;
+            } else {
+                auto n = static_cast<size_t>(num_vertices);
+                cost += kTriangulatePerIndexCost * n * n;
+            }
+            if (cost >= kTriangulateSubdivideCost) {
+                auto size = fsrc_end - fsrc_begin;
+                mesh_tasks.emplace_back(&mesh, nullptr, cost, isrc_begin, idst_begin, fsrc_begin, fdst_begin, size);
 
-    auto num_blocks             = file->size() / kBlockSize + (file->size() % kBlockSize != 0);
-    auto stop_parsing_after_eol = false;
-    auto chunk                  = &chunks->front();
+                isrc_begin = isrc_end;
+                idst_begin = idst_end;
+                fsrc_begin = fsrc_end;
+                fdst_begin = fdst_end;
 
-    ProcessBlocks(source, 0, 0, num_blocks, stop_parsing_after_eol, chunk, context);
-}
+                cost = 0;
+            }
 
-inline void ParseFileParallel(sys::File* file, std::vector<Chunk>* chunks, std::shared_ptr<SharedContext> context)
-{
-    auto source                = DataSource(file);
-    auto num_blocks            = file->size() / kBlockSize + (file->size() % kBlockSize != 0);
-    auto num_threads           = std::thread::hardware_concurrency();
-    auto num_blocks_per_thread = num_blocks / num_threads;
-    auto num_remainder_blocks  = num_blocks - (num_blocks_per_thread * num_threads);
+            isrc_end += num_vertices;
+            idst_end += 3 * num_triangles;
+            fsrc_end += 1;
+            fdst_end += num_triangles;
+        }
 
-    auto tasks = std::vector<size_t>();
+        if (triangle_sum == mesh.num_face_vertices.size()) {
+            continue;
+        }
 
-    tasks.reserve(num_threads);
+        if (auto size = fsrc_end - fsrc_begin; size > 0) {
+            mesh_tasks.emplace_back(&mesh, nullptr, cost, isrc_begin, idst_begin, fsrc_begin, fdst_begin, size);
+        }
 
-    // allocate blocks to tasks
-    {
-        auto block = size_t{};
+        meshes[i].indices             = Array<Index>(3 * triangle_sum, resource);
+        meshes[i].num_face_vertices   = Array<uint8_t>(triangle_sum, resource);
+        meshes[i].material_ids        = Array<int32_t>(triangle_sum, resource);
+        meshes[i].smoothing_group_ids = Array<uint32_t>(triangle_sum, resource);
 
-        while (block < num_blocks) {
-            tasks.push_back(block);
-            block += num_blocks_per_thread;
-            if (num_remainder_blocks > 0) {
-                ++block;
-                --num_remainder_blocks;
-            }
+        for (auto& task : mesh_tasks) {
+            task.dst = &meshes[i];
         }
-    }
 
-    auto num_tasks = tasks.size();
-    auto threads   = std::vector<std::thread>{};
+        tasks.insert(tasks.end(), mesh_tasks.begin(), mesh_tasks.end());
+    }
 
-    chunks->resize(num_tasks);
+    // already triangulated
+    if (tasks.empty()) {
+        return true;
+    }
 
-    context->thread.concurrency   = num_threads;
-    context->parsing.thread_count = num_tasks;
+    auto thread           = SharedContext::Thread{ 0, options.thread_pool, options.max_threads, options.cpu_affinity };
+    auto hardware_threads = AvailableThreads(thread);
+    auto concurrency      = std::min(hardware_threads, tasks.size());
+    bool success          = true;
 
-    context->debug.io.num_requests.resize(num_threads);
-    context->debug.io.num_bytes_read.resize(num_threads);
-    context->debug.io.submit_time.resize(num_threads);
-    context->debug.io.wait_time.resize(num_threads);
-    context->debug.parse.time.resize(num_threads);
+    if (concurrency > 1) {
+        success = TriangulateTasksParallel(thread, concurrency, result.attributes.positions, tasks);
+    } else {
+        success = TriangulateTasksSequential(result.attributes.positions, tasks);
+    }
 
-    threads.reserve(num_tasks);
+    if (!success) {
+        result.error = Error{ make_error_code(rapidobj_errc::TriangulationError), {}, {} };
+    }
 
-    // allocate tasks to threads
-    for (size_t i = 0; i != tasks.size(); ++i) {
-        bool is_last                = i + 1 == tasks.size();
-        auto begin                  = tasks[i];
-        auto end                    = is_last ? num_blocks : (tasks[i + 1] + 1);
-        bool stop_parsing_after_eol = !is_last;
-        auto chunk                  = &(*chunks)[i];
+    auto old_meshes = std::vector<Mesh>();
+    old_meshes.reserve(result.shapes.size());
 
-        threads.emplace_back(ProcessBlocks, source, i, begin, end, stop_parsing_after_eol, chunk, context);
-        threads.back().detach();
+    for (size_t i = 0; i != result.shapes.size(); ++i) {
+        if (!meshes[i].indices.empty()) {
+            old_meshes.push_back(std::move(result.shapes[i].mesh));
+            result.shapes[i].mesh = std::move(meshes[i]);
+        }
     }
 
-    // wait for parsing to finish
-    context->parsing.completed.get_future().wait();
-}
+    auto memory = size_t{ 0 };
 
-inline Result ParseFile(const std::filesystem::path& filepath, const MaterialLibrary& material_library)
-{
-    if (filepath.empty()) {
-        auto error = std::make_error_code(std::errc::invalid_argument);
-        return Result{ Attributes{}, Shapes{}, Materials{}, Error{ error } };
+    for (const auto& old_mesh : old_meshes) {
+        memory += SizeInBytes(old_mesh);
     }
 
-    auto file = sys::File(filepath);
+    // Free memory on the background thread; memory that came from a caller's resource is given back right away, since
+    // the caller may destroy the resource as soon as Triangulate returns
+    auto caller_owned = [](const auto& array) {
+        return array.resource() && array.resource() != HugePageResource::Instance();
+    };
+    bool recyclable = std::none_of(old_meshes.begin(), old_meshes.end(), [&](const Mesh& mesh) {
+        return caller_owned(mesh.indices) || caller_owned(mesh.num_face_vertices) || caller_owned(mesh.material_ids) ||
+               caller_owned(mesh.smoothing_group_ids);
+    });
 
-    if (!file) {
-        return Result{ Attributes{}, Shapes{}, Materials{}, Error{ file.error() } };
+    if (recyclable && memory > kMemoryRecyclingSize) {
+        DeferredFreeQueue::Instance().Push(std::move(old_meshes));
     }
 
-    const auto material_library_value   = &material_library.Value();
-    const auto default_loading_policy   = material_library.Policy().value_or(Load::Mandatory);
-    const auto default_material_library = MaterialLibrary::SearchPath(".", default_loading_policy);
+    return success;
+}
 
-    auto context = std::make_shared<SharedContext>();
+// Calls function(i) for every i below num_tasks, on num_threads threads (the calling thread is one of them), and waits
+// until all calls have returned.
+template <typename Function>
+void RunTasks(const SharedContext::Thread& thread, size_t num_threads, size_t num_tasks, const Function& function)
+{
+    struct State final {
+        std::atomic_size_t next_task{};
+        std::atomic_size_t thread_count{};
+        std::promise<void> completed{};
+    };
 
-    context->material.basepath = filepath.parent_path();
+    auto state = std::make_shared<State>();
 
-    if (std::get_if<std::nullptr_t>(material_library_value) != nullptr) {
-        context->material.library = nullptr;
-    } else if (std::get_if<std::monostate>(material_library_value) != nullptr) {
-        context->material.library = &default_material_library;
-    } else if (auto* paths = std::get_if<std::vector<std::filesystem::path>>(material_library_value)) {
-        if (paths->empty()) {
-            return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::InvalidArgumentsError } };
+    state->thread_count = num_threads;
+
+    auto run_tasks = [state, num_tasks, &function]() {
+        for (auto i = state->next_task++; i < num_tasks; i = state->next_task++) {
+            function(i);
         }
-        context->material.library = &material_library;
-    } else if (std::get_if<std::string_view>(material_library_value) != nullptr) {
-        context->material.library = &material_library;
-    } else {
-        return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::InternalError } };
+        if (1 == std::atomic_fetch_sub(&state->thread_count, size_t(1))) {
+            state->completed.set_value();
+        }
+    };
+
+    for (size_t i = 1; i < num_threads; ++i) {
+        RunAsync(thread, run_tasks);
     }
 
-    auto chunks = std::vector<Chunk>();
+    run_tasks();
 
-    auto t1 = std::chrono::steady_clock::now();
+    Wait(thread, state->completed.get_future());
+}
 
-    if (file.size() <= kSingleThreadCutoff) {
-        ParseFileSequential(&file, &chunks, context);
-    } else {
-        ParseFileParallel(&file, &chunks, context);
-    }
+// A face corner, as sorted into a hash table partition by WeldVertices.
+struct WeldCorner final {
+    Index    index;
+    uint32_t corner; // position among the face corners of all shapes
+};
 
-    auto t2 = std::chrono::steady_clock::now();
+inline uint32_t HashIndex(const Index& index) noexcept
+{
+    auto hash = static_cast<uint64_t>(static_cast<uint32_t>(index.position_index)) * 0x9E3779B97F4A7C15ULL;
 
-    context->debug.parse.total_time = t2 - t1;
+    hash ^= static_cast<uint64_t>(static_cast<uint32_t>(index.texcoord_index)) * 0xC2B2AE3D27D4EB4FULL;
+    hash ^= static_cast<uint64_t>(static_cast<uint32_t>(index.normal_index)) * 0x165667B19E3779F9ULL;
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32;
 
-    // check if an error occured
-    size_t running_line_num = size_t{};
-    for (auto& chunk : chunks) {
-        if (chunk.error.code) {
-            chunk.error.line_num += running_line_num;
-            return Result{ Attributes{}, Shapes{}, Materials{}, chunk.error };
+    return static_cast<uint32_t>(hash);
+}
+
+inline bool SameIndex(const Index& lhs, const Index& rhs) noexcept
+{
+    return lhs.position_index == rhs.position_index && lhs.texcoord_index == rhs.texcoord_index &&
+           lhs.normal_index == rhs.normal_index;
+}
+
+// Calls function(corner, index) for the face corners in [begin, end), which may span several shapes; offsets holds the
+// position of the first corner of each shape, followed by the total number of corners.
+template <typename Function>
+void ForEachCorner(
+    const Result&              result,
+    const std::vector<size_t>& offsets,
+    size_t                     begin,
+    size_t                     end,
+    Function&&                 function)
+{
+    auto shape = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin()) - 1;
+
+    for (auto corner = begin; corner < end; ++shape) {
+        const auto& indices = result.shapes[shape].mesh.indices;
+        auto        last    = std::min(end, offsets[shape + 1]);
+        for (; corner < last; ++corner) {
+            function(corner, indices[corner - offsets[shape]]);
         }
-        running_line_num += chunk.text.line_count;
     }
+}
 
-    t1 = std::chrono::steady_clock::now();
-
-    auto result = Merge(chunks, context);
+// The face corners are sorted into partitions by their hash, block by block, and each partition is then welded on its
+// own, with a hash table that maps each index combination to the first corner that uses it. Blocks are sorted in
+// order, so the first corner found in a partition is the first one in the file, and the result does not depend on the
+// number of threads. Last, the vertices are numbered in order of first use.
+inline WeldedResult WeldVertices(const Result& result, const Options& options)
+{
+    auto welded = WeldedResult{};
 
-    t2 = std::chrono::steady_clock::now();
+    if (result.error) {
+        welded.error = Error{ std::make_error_code(std::errc::invalid_argument) };
+        return welded;
+    }
 
-    context->debug.merge.total_time = t2 - t1;
+    auto offsets = std::vector<size_t>(result.shapes.size() + 1);
 
-    // std::cout << DumpDebug(*context);
+    for (size_t i = 0; i != result.shapes.size(); ++i) {
+        offsets[i + 1] = offsets[i] + result.shapes[i].mesh.indices.size();
+    }
 
-    auto memory = size_t{ 0 };
+    auto num_corners = offsets.back();
 
-    for (const auto& chunk : chunks) {
-        memory += SizeInBytes(chunk);
+    // corners are numbered with 32 bit integers
+    if (num_corners >= std::numeric_limits<uint32_t>::max()) {
+        welded.error = Error{ std::make_error_code(std::errc::value_too_large) };
+        return welded;
     }
 
-    // Free memory in a different thread
-    if (memory > kMemoryRecyclingSize) {
-        auto recycle = std::thread([](std::vector<Chunk>&&) {}, std::move(chunks));
-        recycle.detach();
+    if (num_corners == 0) {
+        return welded;
     }
 
-    return result;
-}
+    auto thread         = SharedContext::Thread{ 0, options.thread_pool, options.max_threads, options.cpu_affinity };
+    auto num_blocks     = (num_corners + kWeldBlockSize - 1) / kWeldBlockSize;
+    auto num_threads    = std::min(AvailableThreads(thread), num_blocks);
+    auto num_partitions = num_threads > 1 ? kWeldPartitions : size_t(1);
+    auto resource       = ResultMemoryResource(options);
+
+    auto block_range = [num_corners](size_t block) {
+        auto begin = block * kWeldBlockSize;
+        return std::make_pair(begin, std::min(begin + kWeldBlockSize, num_corners));
+    };
+
+    auto partition_of = [num_partitions](const Index& index) {
+        return static_cast<size_t>((uint64_t{ HashIndex(index) } * num_partitions) >> 32);
+    };
+
+    // count the corners of each block that go to each partition
+    auto starts = std::vector<size_t>(num_partitions * num_blocks + 1); // by partition, then by block
+
+    RunTasks(thread, num_threads, num_blocks, [&](size_t block) {
+        auto [begin, end] = block_range(block);
+        auto counts       = std::array<size_t, kWeldPartitions>{};
+        ForEachCorner(result, offsets, begin, end, [&](size_t, const Index& index) { ++counts[partition_of(index)]; });
+        for (size_t partition = 0; partition != num_partitions; ++partition) {
+            starts[partition * num_blocks + block + 1] = counts[partition];
+        }
+    });
+
+    std::partial_sum(starts.begin(), starts.end(), starts.begin());
+
+    // sort the corners into partitions; within a partition, they stay in order
+    auto corners = Buffer<WeldCorner>(num_corners);
 
-inline Result ParseStream(std::istream& is, const MaterialLibrary& material_library)
-{
-    auto context                  = std::make_shared<SharedContext>();
-    auto chunks                   = std::vector<Chunk>(1);
-    auto source                   = DataSource(&is);
-    auto num_blocks               = std::numeric_limits<size_t>::max();
-    auto stop_parsing_after_eol   = false;
-    auto chunk                    = &chunks.front();
-    auto material_library_value   = &material_library.Value();
-    auto default_material_library = MaterialLibrary::SearchPaths({}, Load::Optional);
+    RunTasks(thread, num_threads, num_blocks, [&](size_t block) {
+        auto [begin, end] = block_range(block);
+        auto positions    = std::array<size_t, kWeldPartitions>{};
+        for (size_t partition = 0; partition != num_partitions; ++partition) {
+            positions[partition] = starts[partition * num_blocks + block];
+        }
+        ForEachCorner(result, offsets, begin, end, [&](size_t corner, const Index& index) {
+            corners.data()[positions[partition_of(index)]++] = { index, static_cast<uint32_t>(corner) };
+        });
+    });
 
-    if (std::get_if<std::nullptr_t>(material_library_value) != nullptr) {
-        context->material.library = nullptr;
-    } else if (std::get_if<std::monostate>(material_library_value) != nullptr) {
-        if (material_library.Policy()) {
-            return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::InvalidArgumentsError } };
+    // each corner gets the number of the first corner with the same index combination
+    auto first = Array<uint32_t>(num_corners, resource);
+
+    RunTasks(thread, num_threads, num_partitions, [&](size_t partition) {
+        auto begin     = corners.data() + starts[partition * num_blocks];
+        auto end       = corners.data() + starts[(partition + 1) * num_blocks];
+        auto num_slots = size_t(16);
+        while (num_slots < 2 * static_cast<size_t>(end - begin)) {
+            num_slots *= 2;
         }
-        context->material.library = &default_material_library;
-    } else if (auto* paths = std::get_if<std::vector<std::filesystem::path>>(material_library_value)) {
-        if (paths->empty()) {
-            return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::InvalidArgumentsError } };
+        auto table = std::vector<uint32_t>(num_slots); // position in the partition + 1 (0: empty slot)
+        for (auto it = begin; it != end; ++it) {
+            auto slot = HashIndex(it->index) & (num_slots - 1);
+            while (table[slot] != 0 && !SameIndex(begin[table[slot] - 1].index, it->index)) {
+                slot = (slot + 1) & (num_slots - 1);
+            }
+            if (table[slot] == 0) {
+                table[slot]       = static_cast<uint32_t>(it - begin + 1);
+                first[it->corner] = it->corner;
+            } else {
+                first[it->corner] = begin[table[slot] - 1].corner;
+            }
         }
-        if (std::any_of(paths->begin(), paths->end(), [](auto& path) { return path.is_relative(); })) {
-            return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::MaterialRelativePathError } };
+    });
+
+    // number the vertices in order of first use; blocks are a multiple of 64 corners, so each block has its own words
+    auto num_vertices = std::vector<size_t>(num_blocks + 1); // before each block
+    auto is_first     = std::vector<uint64_t>((num_corners + 63) / 64);
+
+    RunTasks(thread, num_threads, num_blocks, [&](size_t block) {
+        auto [begin, end] = block_range(block);
+        auto count        = size_t{};
+        for (auto corner = begin; corner != end; ++corner) {
+            if (first[corner] == corner) {
+                is_first[corner / 64] |= uint64_t(1) << (corner % 64);
+                ++count;
+            }
         }
-        context->material.library = &material_library;
-    } else if (std::get_if<std::string_view>(material_library_value) != nullptr) {
-        context->material.library = &material_library;
-    } else {
-        return Result{ Attributes{}, Shapes{}, Materials{}, Error{ rapidobj_errc::InternalError } };
-    }
+        num_vertices[block + 1] = count;
+    });
 
-    context->thread.concurrency   = 1;
-    context->parsing.thread_count = 1;
+    std::partial_sum(num_vertices.begin(), num_vertices.end(), num_vertices.begin());
 
-    context->debug.io.num_requests.resize(1);
-    context->debug.io.num_bytes_read.resize(1);
-    context->debug.io.submit_time.resize(1);
-    context->debug.io.wait_time.resize(1);
-    context->debug.parse.time.resize(1);
+    welded.vertices = Array<Index>(num_vertices.back(), resource);
 
-    auto t1 = std::chrono::steady_clock::now();
+    auto is_first_corner = [&is_first](size_t corner) { return (is_first[corner / 64] >> (corner % 64)) & 1; };
 
-    ProcessBlocks(source, 0, 0, num_blocks, stop_parsing_after_eol, chunk, context);
+    RunTasks(thread, num_threads, num_blocks, [&](size_t block) {
+        auto [begin, end] = block_range(block);
+        auto vertex       = num_vertices[block];
+        ForEachCorner(result, offsets, begin, end, [&](size_t corner, const Index& index) {
+            if (is_first_corner(corner)) {
+                welded.vertices[vertex] = index;
+                first[corner]           = static_cast<uint32_t>(vertex++);
+            }
+        });
+    });
 
-    auto t2 = std::chrono::steady_clock::now();
+    // the other corners take the vertex of their first corner, which is no longer changing
+    RunTasks(thread, num_threads, num_blocks, [&](size_t block) {
+        auto [begin, end] = block_range(block);
+        for (auto corner = begin; corner != end; ++corner) {
+            if (!is_first_corner(corner)) {
+                first[corner] = first[first[corner]];
+            }
+        }
+    });
 
-    context->debug.parse.total_time = t2 - t1;
+    welded.indices = std::move(first);
+
+    return welded;
+}
 
-    if (chunks.front().error.code) {
-        return Result{ Attributes{}, Shapes{}, Materials{}, chunks.front().error };
+struct ArrayAccess final {
+    template <typename T>
+    static Array<T> Adopt(T* data, size_t size, MemoryResource* resource) noexcept
+    {
+        return Array<T>(data, size, resource);
     }
+};
 
-    t1 = std::chrono::steady_clock::now();
+// A file written by SaveBinary starts with a BinaryHeader, followed by a BinaryShape record for each shape. The encoded
+// materials, the shape names, and the attribute and index arrays come next, each aligned to kBinaryAlignment bytes. The
+// arrays are stored exactly as they are laid out in memory, so that LoadBinary can point Result arrays into the file.
+struct BinaryArray final {
+    uint64_t offset; // from the start of the file
+    uint64_t size;   // number of elements
+};
 
-    auto result = Merge(chunks, context);
+struct BinaryHeader final {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    byte_order;
+    uint64_t    file_size;
+    uint64_t    num_shapes;
+    uint64_t    num_materials;
+    BinaryArray materials; // encoded with MaterialEncoder
+    BinaryArray positions;
+    BinaryArray texcoords;
+    BinaryArray normals;
+    BinaryArray colors;
+};
 
-    t2 = std::chrono::steady_clock::now();
+struct BinaryShape final {
+    BinaryArray name;
+    BinaryArray mesh_indices;
+    BinaryArray mesh_num_face_vertices;
+    BinaryArray mesh_material_ids;
+    BinaryArray mesh_smoothing_group_ids;
+    BinaryArray lines_indices;
+    BinaryArray lines_num_line_vertices;
+    BinaryArray points_indices;
+};
 
-    context->debug.merge.total_time = t2 - t1;
+static_assert(std::is_trivially_copyable_v<BinaryHeader> && sizeof(BinaryHeader) % alignof(BinaryShape) == 0);
+static_assert(std::is_trivially_copyable_v<BinaryShape> && sizeof(BinaryShape) == 8 * sizeof(BinaryArray));
 
-    // std::cout << DumpDebug(*context);
+// Calls visit on each member of the texture option, in declaration order.
+template <typename TextureOptionType, typename Visitor>
+void VisitTextureOption(TextureOptionType& option, Visitor& visit)
+{
+    visit(option.type);
+    visit(option.sharpness);
+    visit(option.brightness);
+    visit(option.contrast);
+    visit(option.origin_offset);
+    visit(option.scale);
+    visit(option.turbulence);
+    visit(option.texture_resolution);
+    visit(option.clamp);
+    visit(option.imfchan);
+    visit(option.blendu);
+    visit(option.blendv);
+    visit(option.bump_multiplier);
+}
+
+// Calls visit on each member of the material, in declaration order.
+template <typename MaterialType, typename Visitor>
+void VisitMaterial(MaterialType& material, Visitor& visit)
+{
+    visit(material.name);
+    visit(material.ambient);
+    visit(material.diffuse);
+    visit(material.specular);
+    visit(material.transmittance);
+    visit(material.emission);
+    visit(material.shininess);
+    visit(material.ior);
+    visit(material.dissolve);
+    visit(material.illum);
+    visit(material.ambient_texname);
+    visit(material.diffuse_texname);
+    visit(material.specular_texname);
+    visit(material.specular_highlight_texname);
+    visit(material.bump_texname);
+    visit(material.displacement_texname);
+    visit(material.alpha_texname);
+    visit(material.reflection_texname);
+    visit(material.ambient_texopt);
+    visit(material.diffuse_texopt);
+    visit(material.specular_texopt);
+    visit(material.specular_highlight_texopt);
+    visit(material.bump_texopt);
+    visit(material.displacement_texopt);
+    visit(material.alpha_texopt);
+    visit(material.reflection_texopt);
+    visit(material.roughness);
+    visit(material.metallic);
+    visit(material.sheen);
+    visit(material.clearcoat_thickness);
+    visit(material.clearcoat_roughness);
+    visit(material.anisotropy);
+    visit(material.anisotropy_rotation);
+    visit(material.roughness_texname);
+    visit(material.metallic_texname);
+    visit(material.sheen_texname);
+    visit(material.emissive_texname);
+    visit(material.normal_texname);
+    visit(material.roughness_texopt);
+    visit(material.metallic_texopt);
+    visit(material.sheen_texopt);
+    visit(material.emissive_texopt);
+    visit(material.normal_texopt);
+}
+
+// Materials hold strings, so they are encoded member by member: a string as its 64-bit size followed by its characters,
+// a bool as one byte, and any other member as its bytes.
+struct MaterialEncoder final {
+    void operator()(const std::string& text)
+    {
+        (*this)(static_cast<uint64_t>(text.size()));
+        out->append(text);
+    }
+    void operator()(const TextureOption& option) { VisitTextureOption(option, *this); }
+    void operator()(bool value) { out->push_back(value ? 1 : 0); }
 
-    // Free memory in a different thread
-    if (SizeInBytes(chunks.front()) > kMemoryRecyclingSize) {
-        auto recycle = std::thread([](std::vector<Chunk>&&) {}, std::move(chunks));
-        recycle.detach();
+    template <typename T>
+    void operator()(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out->append(reinterpret_cast<const char*>(&value), sizeof(T));
     }
 
-    return result;
-}
+    std::string* out;
+};
 
-struct TriangulateTask final {
-    TriangulateTask(
-        const Mesh* src_,
-        Mesh*       dst_,
-        size_t      cost_,
-        size_t      isrc_,
-        size_t      idst_,
-        size_t      fsrc_,
-        size_t      fdst_,
-        size_t      size_) noexcept
-        : src(src_), dst(dst_), cost(cost_), isrc(isrc_), idst(idst_), fsrc(fsrc_), fdst(fdst_), size(size_)
-    {}
+struct MaterialDecoder final {
+    void operator()(std::string& text)
+    {
+        auto size = uint64_t{};
+        (*this)(size);
+        if (ok && size <= static_cast<uint64_t>(last - first)) {
+            text.assign(first, static_cast<size_t>(size));
+            first += size;
+        } else {
+            ok = false;
+        }
+    }
+    void operator()(TextureOption& option) { VisitTextureOption(option, *this); }
+    void operator()(bool& value)
+    {
+        auto byte = uint8_t{};
+        (*this)(byte);
+        value = byte != 0;
+    }
 
-    const Mesh* src{};
-    Mesh*       dst{};
-    size_t      cost{};
-    size_t      isrc{};
-    size_t      idst{};
-    size_t      fsrc{};
-    size_t      fdst{};
-    size_t      size{};
+    template <typename T>
+    void operator()(T& value)
+    {
+        if (ok && sizeof(T) <= static_cast<size_t>(last - first)) {
+            memcpy(&value, first, sizeof(T));
+            first += sizeof(T);
+        } else {
+            ok = false;
+        }
+    }
+
+    const char* first;
+    const char* last;
+    bool        ok;
 };
 
-inline auto CalculatePolygonArea(float* x, float* y, size_t size) noexcept
-{
-    auto area = 0.0f;
+// Memory resource of the arrays that LoadBinary points into a mapped file. It counts the arrays that refer to it, and
+// unmaps the file and deletes itself when the last one is destroyed. Arrays allocated from it (by code that allocates a
+// new array from the resource of an existing one) get ordinary aligned memory.
+class MappedFileResource final : public MemoryResource {
+  public:
+    struct Releaser final {
+        void operator()(MappedFileResource* resource) const noexcept { resource->Release(); }
+    };
 
-    for (size_t i = 1; i != size; ++i) {
-        auto avg_height = (y[i - 1] + y[i]) / 2;
-        auto width      = x[i] - x[i - 1];
-        area += width * avg_height;
+    // The returned pointer holds the first reference.
+    static std::unique_ptr<MappedFileResource, Releaser> Create(std::unique_ptr<sys::FileMapping> mapping)
+    {
+        return std::unique_ptr<MappedFileResource, Releaser>(new MappedFileResource(std::move(mapping)));
     }
 
-    auto avg_height = (y[0] + y[size - 1]) / 2;
-    auto width      = x[0] - x[size - 1];
-    area += width * avg_height;
-
-    return std::abs(area);
-}
+    // Points an array into the mapping; the array holds a reference until it is destroyed.
+    template <typename T>
+    Array<T> MapArray(const BinaryArray& array) noexcept
+    {
+        if (array.size == 0) {
+            return Array<T>();
+        }
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        // the mapping is copy-on-write, so the array may write to it
+        auto data = reinterpret_cast<T*>(const_cast<char*>(m_mapping->data() + array.offset));
+        return ArrayAccess::Adopt(data, static_cast<size_t>(array.size), this);
+    }
 
-enum class ProjectionPlane { X, Y, Z };
+    void* Allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        auto data = ::operator new(bytes, std::align_val_t(alignment));
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        return data;
+    }
 
-inline bool TriangulateSingleTask(const Array<float>& positions, const TriangulateTask& task)
-{
-    auto [src, dst, cost, isrc, idst, fsrc, fdst, size] = task;
+    void Deallocate(void* pointer, std::size_t, std::size_t alignment) override
+    {
+        auto first  = m_mapping->data();
+        auto last   = m_mapping->data() + m_mapping->size();
+        auto mapped = std::less_equal<>()(first, pointer) && std::less<>()(pointer, last);
+        if (!mapped) {
+            ::operator delete(pointer, std::align_val_t(alignment));
+        }
+        Release();
+    }
 
-    auto  complex   = std::array<std::vector<std::array<float, 2>>, 1>();
-    auto& polygon   = complex.front();
-    auto  index_map = std::vector<size_t>();
+  private:
+    explicit MappedFileResource(std::unique_ptr<sys::FileMapping> mapping) noexcept : m_mapping(std::move(mapping)) {}
 
-    for (size_t i = 0; i != size; ++i) {
-        auto num_vertices = src->num_face_vertices[fsrc + i];
-        auto material_id  = src->material_ids[fsrc + i];
-        auto smoothing_id = src->smoothing_group_ids[fsrc + i];
+    void Release() noexcept
+    {
+        if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
 
-        if (num_vertices == 3) {
-            dst->indices[idst + 0] = src->indices[isrc + 0];
-            dst->indices[idst + 1] = src->indices[isrc + 1];
-            dst->indices[idst + 2] = src->indices[isrc + 2];
+    std::unique_ptr<sys::FileMapping> m_mapping;
+    std::atomic_size_t                m_count{ 1 };
+};
 
-            isrc += 3;
-            idst += 3;
+inline std::error_code SaveBinary(const Result& result, const std::filesystem::path& filepath)
+{
+    if (filepath.empty() || result.error) {
+        return std::make_error_code(std::errc::invalid_argument);
+    }
 
-            dst->num_face_vertices[fdst]   = 3;
-            dst->material_ids[fdst]        = material_id;
-            dst->smoothing_group_ids[fdst] = smoothing_id;
+    struct Section final {
+        uint64_t    offset;
+        const char* data;
+        size_t      size; // in bytes
+    };
 
-            fdst++;
+    auto sections = std::vector<Section>();
+    auto offset   = static_cast<uint64_t>(sizeof(BinaryHeader) + result.shapes.size() * sizeof(BinaryShape));
 
-        } else if (num_vertices == 4) {
-            const auto& index0 = src->indices[isrc + 0];
-            const auto& index1 = src->indices[isrc + 1];
-            const auto& index2 = src->indices[isrc + 2];
-            const auto& index3 = src->indices[isrc + 3];
+    // an Array or a std::string
+    auto place = [&](const auto& array) {
+        if (array.empty()) {
+            return BinaryArray{};
+        }
+        offset     = (offset + kBinaryAlignment - 1) / kBinaryAlignment * kBinaryAlignment;
+        auto bytes = array.size() * sizeof(*array.data());
+        sections.push_back({ offset, reinterpret_cast<const char*>(array.data()), bytes });
+        offset += bytes;
+        return BinaryArray{ sections.back().offset, array.size() };
+    };
 
-            isrc += 4;
+    auto materials = std::string();
+    auto encode    = MaterialEncoder{ &materials };
 
-            bool d02_is_less{};
-            {
-                auto position_index0 = 3 * static_cast<size_t>(index0.position_index);
-                auto position_index1 = 3 * static_cast<size_t>(index1.position_index);
-                auto position_index2 = 3 * static_cast<size_t>(index2.position_index);
-                auto position_index3 = 3 * static_cast<size_t>(index3.position_index);
+    for (const auto& material : result.materials) {
+        VisitMaterial(material, encode);
+    }
 
-                auto pos0_x = positions[position_index0 + 0];
-                auto pos0_y = positions[position_index0 + 1];
-                auto pos0_z = positions[position_index0 + 2];
+    auto header = BinaryHeader{};
+    auto shapes = std::vector<BinaryShape>(result.shapes.size());
 
-                auto pos1_x = positions[position_index1 + 0];
-                auto pos1_y = positions[position_index1 + 1];
-                auto pos1_z = positions[position_index1 + 2];
+    memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
 
-                auto pos2_x = positions[position_index2 + 0];
-                auto pos2_y = positions[position_index2 + 1];
-                auto pos2_z = positions[position_index2 + 2];
+    header.version       = kBinaryVersion;
+    header.byte_order    = kBinaryByteOrder;
+    header.num_shapes    = result.shapes.size();
+    header.num_materials = result.materials.size();
+    header.materials     = place(materials);
+    header.positions     = place(result.attributes.positions);
+    header.texcoords     = place(result.attributes.texcoords);
+    header.normals       = place(result.attributes.normals);
+    header.colors        = place(result.attributes.colors);
 
-                auto pos3_x = positions[position_index3 + 0];
-                auto pos3_y = positions[position_index3 + 1];
-                auto pos3_z = positions[position_index3 + 2];
+    for (size_t i = 0; i != result.shapes.size(); ++i) {
+        const auto& shape = result.shapes[i];
+        auto&       out   = shapes[i];
 
-                auto e02_x = pos0_x - pos2_x;
-                auto e02_y = pos0_y - pos2_y;
-                auto e02_z = pos0_z - pos2_z;
+        out.name                     = place(shape.name);
+        out.mesh_indices             = place(shape.mesh.indices);
+        out.mesh_num_face_vertices   = place(shape.mesh.num_face_vertices);
+        out.mesh_material_ids        = place(shape.mesh.material_ids);
+        out.mesh_smoothing_group_ids = place(shape.mesh.smoothing_group_ids);
+        out.lines_indices            = place(shape.lines.indices);
+        out.lines_num_line_vertices  = place(shape.lines.num_line_vertices);
+        out.points_indices           = place(shape.points.indices);
+    }
 
-                auto e13_x = pos1_x - pos3_x;
-                auto e13_y = pos1_y - pos3_y;
-                auto e13_z = pos1_z - pos3_z;
+    header.file_size = offset;
 
-                auto d02 = e02_x * e02_x + e02_y * e02_y + e02_z * e02_z;
-                auto d13 = e13_x * e13_x + e13_y * e13_y + e13_z * e13_z;
+    auto file = std::ofstream(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
 
-                d02_is_less = d02 < d13;
-            }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(shapes.data()), shapes.size() * sizeof(BinaryShape));
 
-            dst->indices[idst + 0] = index0;
-            dst->indices[idst + 1] = index1;
-            dst->indices[idst + 2] = d02_is_less ? index2 : index3;
-            dst->indices[idst + 3] = d02_is_less ? index0 : index1;
-            dst->indices[idst + 4] = index2;
-            dst->indices[idst + 5] = index3;
+    auto position = static_cast<uint64_t>(sizeof(BinaryHeader) + shapes.size() * sizeof(BinaryShape));
 
-            idst += 6;
+    for (const auto& section : sections) {
+        static constexpr char padding[kBinaryAlignment] = {};
+        file.write(padding, static_cast<std::streamsize>(section.offset - position));
+        file.write(section.data, static_cast<std::streamsize>(section.size));
+        position = section.offset + section.size;
+    }
 
-            dst->num_face_vertices[fdst + 0]   = 3;
-            dst->num_face_vertices[fdst + 1]   = 3;
-            dst->material_ids[fdst + 0]        = material_id;
-            dst->material_ids[fdst + 1]        = material_id;
-            dst->smoothing_group_ids[fdst + 0] = smoothing_id;
-            dst->smoothing_group_ids[fdst + 1] = smoothing_id;
+    file.close();
 
-            fdst += 2;
-        } else {
-            auto xs = std::array<float, kMaxVerticesInFace>();
-            auto ys = std::array<float, kMaxVerticesInFace>();
-            auto zs = std::array<float, kMaxVerticesInFace>();
+    return file ? std::error_code() : std::make_error_code(std::errc::io_error);
+}
 
-            polygon.clear();
-            index_map.clear();
+template <typename T>
+bool IsValid(const BinaryArray& array, uint64_t file_size) noexcept
+{
+    return array.offset % alignof(T) == 0 && array.offset <= file_size &&
+           array.size <= (file_size - array.offset) / sizeof(T);
+}
 
-            for (size_t k = 0; k != num_vertices; ++k) {
-                auto position_index = 3 * static_cast<size_t>(src->indices[isrc + k].position_index);
-                index_map.push_back(isrc + k);
-                xs[k] = positions[position_index + 0];
-                ys[k] = positions[position_index + 1];
-                zs[k] = positions[position_index + 2];
-            }
+inline bool IsValid(const BinaryShape& shape, uint64_t file_size) noexcept
+{
+    return IsValid<char>(shape.name, file_size) && IsValid<Index>(shape.mesh_indices, file_size) &&
+           IsValid<uint8_t>(shape.mesh_num_face_vertices, file_size) &&
+           IsValid<int32_t>(shape.mesh_material_ids, file_size) &&
+           IsValid<uint32_t>(shape.mesh_smoothing_group_ids, file_size) &&
+           IsValid<Index>(shape.lines_indices, file_size) &&
+           IsValid<int32_t>(shape.lines_num_line_vertices, file_size) &&
+           IsValid<Index>(shape.points_indices, file_size);
+}
+
+// The structure of the file is checked (every array must lie within it), but not the values it holds; a file that was
+// not written by SaveBinary, or was modified afterwards, may produce a Result with out of bounds indices.
+inline Result LoadBinary(const std::filesystem::path& filepath)
+{
+    if (filepath.empty()) {
+        auto error = std::make_error_code(std::errc::invalid_argument);
+        return Result{ {}, {}, {}, Error{ error } };
+    }
 
-            isrc += num_vertices;
+    auto file = sys::File(filepath);
 
-            auto area_x = CalculatePolygonArea(ys.data(), zs.data(), num_vertices);
-            auto area_y = CalculatePolygonArea(xs.data(), zs.data(), num_vertices);
-            auto area_z = CalculatePolygonArea(xs.data(), ys.data(), num_vertices);
+    if (!file) {
+        return Result{ {}, {}, {}, Error{ file.error() } };
+    }
 
-            if (FLT_MIN > std::max({ area_x, area_y, area_z })) {
-                return false;
-            }
+    auto format_error = Result{ {}, {}, {}, Error{ rapidobj_errc::BinaryFormatError } };
 
-            auto proj_plane = ProjectionPlane{};
+    if (file.size() < sizeof(BinaryHeader)) {
+        return format_error;
+    }
 
-            if (area_x > area_y) {
-                proj_plane = area_x > area_z ? ProjectionPlane::X : ProjectionPlane::Z;
-            } else {
-                proj_plane = area_y > area_z ? ProjectionPlane::Y : ProjectionPlane::Z;
-            }
+    auto mapping = std::make_unique<sys::FileMapping>(file, false, true);
 
-            if (proj_plane == ProjectionPlane::X) {
-                for (size_t k = 0; k != num_vertices; ++k) {
-                    polygon.push_back({ ys[k], zs[k] });
-                }
-            } else if (proj_plane == ProjectionPlane::Y) {
-                for (size_t k = 0; k != num_vertices; ++k) {
-                    polygon.push_back({ xs[k], zs[k] });
-                }
-            } else {
-                for (size_t k = 0; k != num_vertices; ++k) {
-                    polygon.push_back({ xs[k], ys[k] });
-                }
-            }
+    if (!*mapping) {
+        return Result{ {}, {}, {}, Error{ mapping->error() } };
+    }
 
-            auto result = mapbox::earcut(complex);
+    const auto data      = mapping->data();
+    const auto file_size = static_cast<uint64_t>(mapping->size());
 
-            if (result.empty() || result.size() % 3 != 0) {
-                return false;
-            }
+    auto header = BinaryHeader{};
 
-            for (size_t k = 0; k < result.size(); k += 3) {
-                std::swap(result[k], result[k + 1]);
-            }
+    memcpy(&header, data, sizeof(header));
 
-            for (size_t k = 0; k != result.size(); ++k) {
-                dst->indices[idst + k] = src->indices[index_map[result[k]]];
-            }
+    bool valid_header = memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0 &&
+                        header.version == kBinaryVersion && header.byte_order == kBinaryByteOrder &&
+                        header.file_size == file_size &&
+                        header.num_shapes <= (file_size - sizeof(BinaryHeader)) / sizeof(BinaryShape) &&
+                        IsValid<char>(header.materials, file_size) && IsValid<float>(header.positions, file_size) &&
+                        IsValid<float>(header.texcoords, file_size) && IsValid<float>(header.normals, file_size) &&
+                        IsValid<float>(header.colors, file_size);
 
-            idst += result.size();
+    if (!valid_header) {
+        return format_error;
+    }
 
-            auto num_triangles = result.size() / 3;
+    auto shapes = std::vector<BinaryShape>(static_cast<size_t>(header.num_shapes));
 
-            for (size_t k = 0; k != num_triangles; ++k) {
-                dst->num_face_vertices[fdst + k]   = 3;
-                dst->material_ids[fdst + k]        = material_id;
-                dst->smoothing_group_ids[fdst + k] = smoothing_id;
-            }
+    memcpy(shapes.data(), data + sizeof(BinaryHeader), shapes.size() * sizeof(BinaryShape));
 
-            fdst += num_triangles;
+    for (const auto& shape : shapes) {
+        if (!IsValid(shape, file_size)) {
+            return format_error;
         }
     }
-    return true;
-}
 
-inline bool
-TriangulateTasksParallel(size_t concurrency, const Array<float>& positions, const std::vector<TriangulateTask>& tasks)
-{
-    auto task_index  = std::atomic_size_t{ 0 };
-    auto num_threads = std::atomic_size_t{ concurrency };
-    auto completed   = std::promise<void>();
-    auto success     = std::atomic_bool{ true };
+    auto materials = Materials();
+    auto decode    = MaterialDecoder{ data + header.materials.offset,
+                                   data + header.materials.offset + header.materials.size,
+                                   true };
 
-    auto func = [&]() {
-        auto fetched_index = std::atomic_fetch_add(&task_index, size_t(1));
+    for (uint64_t i = 0; i != header.num_materials && decode.ok; ++i) {
+        VisitMaterial(materials.emplace_back(), decode);
+    }
 
-        while (fetched_index < tasks.size()) {
-            if (false == TriangulateSingleTask(positions, tasks[fetched_index])) {
-                success = false;
-                break;
-            }
-            fetched_index = std::atomic_fetch_add(&task_index, size_t(1));
-        }
+    if (!decode.ok || decode.first != decode.last) {
+        return format_error;
+    }
 
-        if (1 == std::atomic_fetch_sub(&num_threads, size_t(1))) {
-            completed.set_value();
-        }
-    };
+    auto resource = MappedFileResource::Create(std::move(mapping));
+    auto result   = Result{};
 
-    auto threads = std::vector<std::thread>();
-    threads.reserve(concurrency);
+    result.attributes.positions = resource->MapArray<float>(header.positions);
+    result.attributes.texcoords = resource->MapArray<float>(header.texcoords);
+    result.attributes.normals   = resource->MapArray<float>(header.normals);
+    result.attributes.colors    = resource->MapArray<float>(header.colors);
 
-    for (size_t i = 0; i != concurrency; ++i) {
-        threads.emplace_back(func);
-        threads.back().detach();
+    result.shapes.reserve(shapes.size());
+
+    for (const auto& shape : shapes) {
+        auto& out = result.shapes.emplace_back();
+
+        out.name.assign(data + shape.name.offset, static_cast<size_t>(shape.name.size));
+
+        out.mesh.indices             = resource->MapArray<Index>(shape.mesh_indices);
+        out.mesh.num_face_vertices   = resource->MapArray<uint8_t>(shape.mesh_num_face_vertices);
+        out.mesh.material_ids        = resource->MapArray<int32_t>(shape.mesh_material_ids);
+        out.mesh.smoothing_group_ids = resource->MapArray<uint32_t>(shape.mesh_smoothing_group_ids);
+        out.lines.indices            = resource->MapArray<Index>(shape.lines_indices);
+        out.lines.num_line_vertices  = resource->MapArray<int32_t>(shape.lines_num_line_vertices);
+        out.points.indices           = resource->MapArray<Index>(shape.points_indices);
     }
 
-    // wait for triangulation to finish
-    completed.get_future().wait();
+    result.materials = std::move(materials);
 
-    return success;
+    return result;
 }
 
-inline bool TriangulateTasksSequential(const Array<float>& positions, const std::vector<TriangulateTask>& tasks)
+// XXH64 (see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md); reads words in host byte order.
+inline uint64_t Xxh64(const void* data, size_t size, uint64_t seed) noexcept
 {
-    for (const auto& task : tasks) {
-        bool success = TriangulateSingleTask(positions, task);
-        if (!success) {
-            return false;
+    constexpr uint64_t p1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t p3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t p4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t p5 = 0x27D4EB2F165667C5ULL;
+
+    auto rotl  = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t acc, uint64_t lane) { return rotl(acc + lane * p2, 31) * p1; };
+    auto merge = [&](uint64_t acc, uint64_t v) { return (acc ^ round(0, v)) * p1 + p4; };
+    auto read8 = [](const unsigned char* p) {
+        auto value = uint64_t{};
+        memcpy(&value, p, sizeof(value));
+        return value;
+    };
+    auto read4 = [](const unsigned char* p) {
+        auto value = uint32_t{};
+        memcpy(&value, p, sizeof(value));
+        return value;
+    };
+
+    auto first = static_cast<const unsigned char*>(data);
+    auto last  = first + size;
+    auto acc   = uint64_t{};
+
+    if (size >= 32) {
+        uint64_t v1 = seed + p1 + p2;
+        uint64_t v2 = seed + p2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - p1;
+        for (; last - first >= 32; first += 32) {
+            v1 = round(v1, read8(first));
+            v2 = round(v2, read8(first + 8));
+            v3 = round(v3, read8(first + 16));
+            v4 = round(v4, read8(first + 24));
         }
+        acc = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        acc = merge(merge(merge(merge(acc, v1), v2), v3), v4);
+    } else {
+        acc = seed + p5;
     }
-    return true;
+
+    acc += size;
+
+    for (; last - first >= 8; first += 8) {
+        acc = rotl(acc ^ round(0, read8(first)), 27) * p1 + p4;
+    }
+    if (last - first >= 4) {
+        acc = rotl(acc ^ (read4(first) * p1), 23) * p2 + p3;
+        first += 4;
+    }
+    for (; first != last; ++first) {
+        acc = rotl(acc ^ (*first * p5), 11) * p1;
+    }
+
+    acc ^= acc >> 33;
+    acc *= p2;
+    acc ^= acc >> 29;
+    acc *= p3;
+    acc ^= acc >> 32;
+
+    return acc;
 }
 
-inline bool Triangulate(Result& result)
+// Returns the position of the first "mtllib" keyword that starts a line within text[begin, end), or npos.
+inline size_t FindMaterialLibraryLine(std::string_view text, size_t begin, size_t end) noexcept
 {
-    auto mesh_tasks = std::vector<TriangulateTask>();
-    auto tasks      = std::vector<TriangulateTask>();
-    auto meshes     = std::vector<Mesh>(result.shapes.size());
+    constexpr auto keyword = std::string_view("mtllib");
 
-    tasks.reserve(result.shapes.size());
+    auto window = text.substr(0, std::min(text.size(), end + keyword.size() - 1));
 
-    for (size_t i = 0; i != result.shapes.size(); ++i) {
-        const auto& mesh = result.shapes[i].mesh;
+    for (auto pos = window.find(keyword, begin); pos != std::string_view::npos; pos = window.find(keyword, pos + 1)) {
+        auto first = pos;
+        while (first > 0 && (text[first - 1] == ' ' || text[first - 1] == '\t')) {
+            --first;
+        }
+        bool line_start = first == 0 || text[first - 1] == '\n';
+        bool separated  = pos + keyword.size() < text.size() &&
+                         (text[pos + keyword.size()] == ' ' || text[pos + keyword.size()] == '\t');
+        if (line_start && separated) {
+            return pos;
+        }
+    }
 
-        mesh_tasks.clear();
+    return std::string_view::npos;
+}
 
-        auto cost = size_t{ 0 };
+struct TextHash final {
+    uint64_t    hash{};
+    std::string library_name{}; // given on the first mtllib line (empty: none)
+};
 
-        auto isrc_begin = size_t{ 0 };
-        auto isrc_end   = size_t{ 0 };
-        auto idst_begin = size_t{ 0 };
-        auto idst_end   = size_t{ 0 };
+// Hashes the text in kHashBlockSize blocks, in parallel; the result is the hash of the sequence of block hashes. While
+// a block is hashed, it is also searched for the mtllib line, so that the material library can be hashed too.
+inline TextHash HashText(std::string_view text, const SharedContext::Thread& thread)
+{
+    struct State final {
+        std::string_view      text{};
+        size_t                num_blocks{};
+        std::vector<uint64_t> hashes{};
+        std::vector<size_t>   mtllib{}; // position of the first mtllib line in each block (npos: none)
+        std::atomic_size_t    next_block{};
+        std::atomic_size_t    thread_count{};
+        std::promise<void>    completed{};
+    };
 
-        auto fsrc_begin = size_t{ 0 };
-        auto fsrc_end   = size_t{ 0 };
-        auto fdst_begin = size_t{ 0 };
-        auto fdst_end   = size_t{ 0 };
+    auto state       = std::make_shared<State>();
+    auto num_blocks  = (text.size() + kHashBlockSize - 1) / kHashBlockSize;
+    auto num_threads = std::clamp(AvailableThreads(thread), size_t(1), std::max(num_blocks, size_t(1)));
+
+    state->text         = text;
+    state->num_blocks   = num_blocks;
+    state->hashes       = std::vector<uint64_t>(num_blocks);
+    state->mtllib       = std::vector<size_t>(num_blocks, std::string_view::npos);
+    state->thread_count = num_threads;
+
+    auto hash_blocks = [state]() {
+        for (auto i = state->next_block++; i < state->num_blocks; i = state->next_block++) {
+            auto begin       = i * kHashBlockSize;
+            auto end         = std::min(begin + kHashBlockSize, state->text.size());
+            state->hashes[i] = Xxh64(state->text.data() + begin, end - begin, 0);
+            state->mtllib[i] = FindMaterialLibraryLine(state->text, begin, end);
+        }
+        if (1 == std::atomic_fetch_sub(&state->thread_count, size_t(1))) {
+            state->completed.set_value();
+        }
+    };
 
-        auto triangle_sum = size_t{ 0 };
+    for (size_t i = 1; i < num_threads; ++i) {
+        RunAsync(thread, hash_blocks);
+    }
 
-        for (auto num_vertices : mesh.num_face_vertices) {
-            auto num_triangles = static_cast<size_t>(num_vertices - 2);
+    hash_blocks();
 
-            triangle_sum += num_triangles;
+    Wait(thread, state->completed.get_future());
 
-            if (num_vertices == 3) {
-                cost += kTriangulateTriangleCost;
-            } else if (num_vertices == 4) {
-                cost += kTriangulateQuadCost;
-            } else {
-                auto n = static_cast<size_t>(num_vertices);
-                cost += kTriangulatePerIndexCost * n * n;
-            }
-            if (cost >= kTriangulateSubdivideCost) {
-                auto size = fsrc_end - fsrc_begin;
-                mesh_tasks.emplace_back(&mesh, nullptr, cost, isrc_begin, idst_begin, fsrc_begin, fdst_begin, size);
+    auto result = TextHash{};
 
-                isrc_begin = isrc_end;
-                idst_begin = idst_end;
-                fsrc_begin = fsrc_end;
-                fdst_begin = fdst_end;
+    result.hash = Xxh64(state->hashes.data(), state->hashes.size() * sizeof(uint64_t), text.size());
 
-                cost = 0;
-            }
+    auto found = [](size_t pos) { return pos != std::string_view::npos; };
+    auto it    = std::find_if(state->mtllib.begin(), state->mtllib.end(), found);
 
-            isrc_end += num_vertices;
-            idst_end += 3 * num_triangles;
-            fsrc_end += 1;
-            fdst_end += num_triangles;
+    if (it != state->mtllib.end()) {
+        auto line = text.substr(*it + 7);
+        line      = line.substr(0, line.find('\n'));
+        if (EndsWith(line, '\r')) {
+            line.remove_suffix(1);
         }
+        Trim(line);
+        result.library_name = line;
+    }
 
-        if (triangle_sum == mesh.num_face_vertices.size()) {
-            continue;
-        }
+    return result;
+}
 
-        if (auto size = fsrc_end - fsrc_begin; size > 0) {
-            mesh_tasks.emplace_back(&mesh, nullptr, cost, isrc_begin, idst_begin, fsrc_begin, fdst_begin, size);
-        }
+// Returns the name of the cache file for the .obj file, or an empty string if the file cannot be hashed. The name is a
+// hash of everything the parsed result depends on: the contents of the .obj file, the material library argument, the
+// contents of the .mtl file it resolves to, and the version of rapidobj.
+inline std::string CacheFileName(
+    const std::filesystem::path& filepath,
+    const MaterialLibrary&       material_library,
+    const Options&               options)
+{
+    auto thread = SharedContext::Thread{ 0, options.thread_pool, options.max_threads, options.cpu_affinity };
 
-        meshes[i].indices             = Array<Index>(3 * triangle_sum);
-        meshes[i].num_face_vertices   = Array<uint8_t>(triangle_sum);
-        meshes[i].material_ids        = Array<int32_t>(triangle_sum);
-        meshes[i].smoothing_group_ids = Array<uint32_t>(triangle_sum);
+    auto file = sys::File(filepath);
 
-        for (auto& task : mesh_tasks) {
-            task.dst = &meshes[i];
+    if (!file || file.size() == 0) {
+        return std::string();
+    }
+
+    auto text_hash = TextHash{};
+
+    if (auto mapping = sys::FileMapping(file, false); mapping) {
+        text_hash = HashText(std::string_view(mapping.data(), mapping.size()), thread);
+    } else {
+        return std::string();
+    }
+
+    auto key    = std::string();
+    auto append = [&key](const auto& value) { key.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    append(Version);
+    append(kBinaryVersion);
+    append(text_hash.hash);
+    append(material_library.Policy().value_or(Load::Mandatory));
+    append(std::array<bool, 3>{ options.skip_texcoords, options.skip_normals, options.skip_colors });
+
+    const auto& value    = material_library.Value();
+    auto        paths    = std::vector<std::filesystem::path>{ "." };
+    bool        resolved = true;
+
+    if (std::holds_alternative<std::nullptr_t>(value)) {
+        key.append("ignore");
+        resolved = false;
+    } else if (auto text = std::get_if<std::string_view>(&value)) {
+        key.append("string");
+        append(Xxh64(text->data(), text->size(), 0));
+        resolved = false;
+    } else if (auto search_paths = std::get_if<std::vector<std::filesystem::path>>(&value)) {
+        paths = *search_paths;
+    }
+
+    if (resolved && !text_hash.library_name.empty()) {
+        auto mtl_filepath = FindBestPath(filepath.parent_path(), paths, text_hash.library_name);
+        key.append(mtl_filepath.string()).push_back('\0');
+        if (!mtl_filepath.empty()) {
+            auto mtl_file = std::ifstream(mtl_filepath, std::ios::in | std::ios::binary);
+            auto mtl_text = std::string(std::istreambuf_iterator<char>(mtl_file), std::istreambuf_iterator<char>());
+            append(Xxh64(mtl_text.data(), mtl_text.size(), 0));
         }
+    }
 
-        tasks.insert(tasks.end(), mesh_tasks.begin(), mesh_tasks.end());
+    auto hash = Xxh64(key.data(), key.size(), 0);
+    auto name = std::string(16, '0');
+
+    for (size_t i = 0; i != name.size(); ++i) {
+        name[name.size() - 1 - i] = "0123456789abcdef"[(hash >> (4 * i)) & 0xF];
     }
 
-    // already triangulated
-    if (tasks.empty()) {
-        return true;
+    return name + ".bin";
+}
+
+// The cache file is written under a temporary name and then renamed, so that other processes never see a partially
+// written file; failing to write it is not an error.
+inline void StoreCacheFile(const Result& result, const std::filesystem::path& cache_filepath)
+{
+    static auto counter = std::atomic_size_t{};
+
+    // unique among the threads of this process, and very likely among processes
+    auto thread_id = std::hash<std::thread::id>()(std::this_thread::get_id());
+    auto time      = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto unique    = std::array<uint64_t, 3>{ uint64_t(thread_id), uint64_t(time), uint64_t(counter++) };
+
+    auto temp_filepath = cache_filepath;
+
+    temp_filepath += "." + std::to_string(Xxh64(unique.data(), sizeof(unique), 0)) + ".tmp";
+
+    auto ec = std::error_code();
+
+    std::filesystem::create_directories(cache_filepath.parent_path(), ec);
+
+    if (detail::SaveBinary(result, temp_filepath)) {
+        std::filesystem::remove(temp_filepath, ec);
+        return;
     }
 
-    auto hardware_threads = static_cast<size_t>(std::thread::hardware_concurrency());
-    auto concurrency      = std::min(hardware_threads, tasks.size());
-    bool success          = true;
+    std::filesystem::rename(temp_filepath, cache_filepath, ec);
 
-    if (concurrency > 1) {
-        success = TriangulateTasksParallel(concurrency, result.attributes.positions, tasks);
-    } else {
-        success = TriangulateTasksSequential(result.attributes.positions, tasks);
+    if (ec) {
+        std::filesystem::remove(temp_filepath, ec);
     }
+}
 
-    if (!success) {
-        result.error = Error{ make_error_code(rapidobj_errc::TriangulationError), {}, {} };
+// Removes the shapes that the filter rejects.
+inline Result SelectShapes(Result result, const std::function<bool(std::string_view)>& shape_filter)
+{
+    if (shape_filter) {
+        auto rejected = [&shape_filter](const Shape& shape) { return !shape_filter(shape.name); };
+        result.shapes.erase(std::remove_if(result.shapes.begin(), result.shapes.end(), rejected), result.shapes.end());
     }
+    return result;
+}
 
-    auto old_meshes = std::vector<Mesh>();
-    old_meshes.reserve(result.shapes.size());
+inline Result ParseFileCached(
+    const std::filesystem::path& filepath,
+    const MaterialLibrary&       material_library,
+    const Options&               options)
+{
+    auto uncached_options = options;
 
-    for (size_t i = 0; i != result.shapes.size(); ++i) {
-        if (!meshes[i].indices.empty()) {
-            old_meshes.push_back(std::move(result.shapes[i].mesh));
-            result.shapes[i].mesh = std::move(meshes[i]);
-        }
+    uncached_options.cache_directory.clear();
+
+    auto cache_key = CacheFileName(filepath, material_library, options);
+
+    if (cache_key.empty()) {
+        return detail::ParseFile<Result>(filepath, material_library, uncached_options);
     }
 
-    auto memory = size_t{ 0 };
+    auto cache_filepath = options.cache_directory / cache_key;
 
-    for (const auto& old_mesh : old_meshes) {
-        memory += SizeInBytes(old_mesh);
+    if (auto cached = LoadBinary(cache_filepath); !cached.error) {
+        return SelectShapes(std::move(cached), options.shape_filter);
     }
 
-    // Free memory in a different thread
-    if (memory > kMemoryRecyclingSize) {
-        auto recycle = std::thread([](std::vector<Mesh>&&) {}, std::move(old_meshes));
-        recycle.detach();
+    // the cache file holds all shapes, so that it serves any shape filter
+    uncached_options.shape_filter = nullptr;
+
+    auto result = detail::ParseFile<Result>(filepath, material_library, uncached_options);
+
+    if (!result.error) {
+        StoreCacheFile(result, cache_filepath);
     }
 
-    return success;
+    return SelectShapes(std::move(result), options.shape_filter);
 }
 
 } // namespace detail
 
+inline void ThreadPool::WorkerLoop(size_t index)
+{
+    CurrentWorker() = Worker{ this, index };
+
+    if (!m_cpu_affinity.empty()) {
+        detail::sys::SetThreadAffinity(m_cpu_affinity);
+    }
+
+    while (true) {
+        if (RunPendingTask()) {
+            continue;
+        }
+        auto lock = std::unique_lock(m_mutex);
+        m_wakeup.wait(lock, [this] { return m_pending > 0 || m_stop; });
+        if (m_stop && m_pending == 0) {
+            break;
+        }
+    }
+}
+
+inline ParserContext::ParserContext() : m_state(std::make_unique<detail::ParserState>()) {}
+
+inline ParserContext::~ParserContext() noexcept = default;
+
+inline size_t ParserContext::Capacity() const
+{
+    using namespace detail;
+
+    auto lock     = std::lock_guard(m_state->mutex);
+    auto capacity = size_t{ 0 };
+
+    for (const auto& chunk : m_state->chunks) {
+        capacity += CapacityInBytes(chunk);
+    }
+
+    capacity += m_state->block_buffers.size() * (kMaxLineLength + kBlockSize);
+    capacity += m_state->batch_buffers.size() * (kMaxLineLength + kStreamBatchSize);
+    capacity += (m_state->merge_tasks.capacity() + m_state->subdivided_tasks.capacity()) * sizeof(MergeTask);
+
+    return capacity;
+}
+
+inline void ParserContext::Clear()
+{
+    auto lock = std::lock_guard(m_state->mutex);
+
+    m_state->chunks           = std::vector<detail::Chunk>();
+    m_state->block_buffers    = std::vector<detail::AlignedBuffer>();
+    m_state->batch_buffers    = std::vector<detail::AlignedBuffer>();
+    m_state->merge_tasks      = detail::MergeTasks();
+    m_state->subdivided_tasks = detail::MergeTasks();
+}
+
 /// <summary>
 /// Loads and parses Wavefront geometry definition file (.obj file).
 /// </summary>
 /// <param name="obj_filepath"> : path of the .obj file to parse.</param>
 /// <param name="mtl_library"> : optional material library.</param>
+/// <param name="options"> : optional parsing options.</param>
 /// <returns>Parsed data stored in Result class.</returns>
-inline Result ParseFile(const std::filesystem::path& obj_filepath, const MaterialLibrary& mtl_library)
+inline Result
+ParseFile(const std::filesystem::path& obj_filepath, const MaterialLibrary& mtl_library, const Options& options)
+{
+    return detail::ParseFile<Result>(obj_filepath, mtl_library, options);
+}
+
+/// <summary>
+/// Loads and parses many Wavefront geometry definition files (.obj files) concurrently.
+/// </summary>
+/// <param name="obj_filepaths"> : paths of the .obj files to parse.</param>
+/// <param name="mtl_library"> : optional material library (applied to every file).</param>
+/// <param name="options"> : optional parsing options.</param>
+/// <returns>Parsed data stored in Result classes, in the same order as obj_filepaths.</returns>
+inline std::vector<Result> ParseFiles(
+    const std::vector<std::filesystem::path>& obj_filepaths,
+    const MaterialLibrary&                    mtl_library,
+    const Options&                            options)
 {
-    return detail::ParseFile(obj_filepath, mtl_library);
+    return detail::ParseFiles(obj_filepaths, mtl_library, options);
 }
 
 /// <summary>
@@ -7697,15 +11963,122 @@ inline Result ParseFile(const std::filesystem::path& obj_filepath, const Materia
 /// </summary>
 /// <param name="obj_stream"> : input stream to parse.</param>
 /// <param name="mtl_library"> : optional material library.</param>
+/// <param name="options"> : optional parsing options.</param>
 /// <returns>Parsed data stored in Result class.</returns>
-inline Result ParseStream(std::istream& obj_stream, const MaterialLibrary& mtl_library)
+inline Result ParseStream(std::istream& obj_stream, const MaterialLibrary& mtl_library, const Options& options)
+{
+    return detail::ParseStream<Result>(obj_stream, mtl_library, options);
+}
+
+/// <summary>
+/// Loads and parses Wavefront geometry definition file (.obj file) without merging the parsed data.
+/// Attributes and indices are returned as lists of segments that point into the parser's own buffers,
+/// which avoids copying them and roughly halves peak memory use for large files.
+/// </summary>
+/// <param name="obj_filepath"> : path of the .obj file to parse.</param>
+/// <param name="mtl_library"> : optional material library.</param>
+/// <param name="options"> : optional parsing options.</param>
+/// <returns>Parsed data stored in SegmentedResult class.</returns>
+inline SegmentedResult ParseFileSegmented(
+    const std::filesystem::path& obj_filepath,
+    const MaterialLibrary&       mtl_library,
+    const Options&               options)
+{
+    return detail::ParseFile<SegmentedResult>(obj_filepath, mtl_library, options);
+}
+
+/// <summary>
+/// Loads and parses Wavefront geometry definition data from an input stream without merging the parsed data.
+/// </summary>
+/// <param name="obj_stream"> : input stream to parse.</param>
+/// <param name="mtl_library"> : optional material library.</param>
+/// <param name="options"> : optional parsing options.</param>
+/// <returns>Parsed data stored in SegmentedResult class.</returns>
+inline SegmentedResult
+ParseStreamSegmented(std::istream& obj_stream, const MaterialLibrary& mtl_library, const Options& options)
+{
+    return detail::ParseStream<SegmentedResult>(obj_stream, mtl_library, options);
+}
+
+inline bool Triangulate(Result& result, const Options& options)
+{
+    return detail::Triangulate(result, options);
+}
+
+/// <summary>
+/// Merges the face corners that use the same combination of position, texcoord and normal indices into one vertex, so
+/// that the meshes can be drawn with a single index buffer. Work is spread over the threads of options.thread_pool (or
+/// temporary threads, if it is not set); the result does not depend on the number of threads.
+/// </summary>
+/// <param name="result"> : parsed data; must not hold an error. Lines and points are not welded.</param>
+/// <param name="options"> : optional options; the threads and the memory resource are chosen as by Triangulate.</param>
+/// <returns>Distinct vertices, and one vertex index per face corner, stored in WeldedResult class.</returns>
+inline WeldedResult WeldVertices(const Result& result, const Options& options)
+{
+    return detail::WeldVertices(result, options);
+}
+
+/// <summary>
+/// Waits until the memory that ParseFile, ParseStream and Triangulate free on a background thread has been freed.
+/// </summary>
+inline void FlushDeferredFrees()
+{
+    detail::DeferredFreeQueue::Instance().Flush();
+}
+
+/// <summary>
+/// Saves parsed data to a binary file that can be loaded with LoadBinary.
+/// </summary>
+/// <param name="result"> : parsed data; must not hold an error.</param>
+/// <param name="filepath"> : path of the binary file to write (an existing file is overwritten).</param>
+/// <returns>Error code; empty if the file was written.</returns>
+inline std::error_code SaveBinary(const Result& result, const std::filesystem::path& filepath)
+{
+    return detail::SaveBinary(result, filepath);
+}
+
+/// <summary>
+/// Loads parsed data saved with SaveBinary. The file is memory mapped and the Result arrays point into it; it is
+/// unmapped when the last of these arrays is destroyed.
+/// </summary>
+/// <param name="filepath"> : path of the binary file to load.</param>
+/// <returns>Loaded data stored in Result class.</returns>
+inline Result LoadBinary(const std::filesystem::path& filepath)
 {
-    return detail::ParseStream(obj_stream, mtl_library);
+    return detail::LoadBinary(filepath);
 }
 
-inline bool Triangulate(Result& result)
+/// <summary>
+/// Parses Wavefront geometry definition file (.obj file) and passes its elements to visitors, instead of returning
+/// them in a Result. The file is parsed in chunks, in parallel; each chunk is handed to its own visitor.
+/// Material libraries are not loaded.
+/// </summary>
+/// <param name="obj_filepath"> : path of the .obj file to parse.</param>
+/// <param name="make_visitor"> : returns the visitor for the chunk with the given index; it is called on the calling
+/// thread, once per chunk and in chunk order, before parsing starts. It must not return nullptr, and the visitors must
+/// outlive the call.</param>
+/// <param name="options"> : optional parsing options.</param>
+/// <returns>Error; if it is set, the visitors may have been given part of the file.</returns>
+inline Error VisitFile(
+    const std::filesystem::path&                       obj_filepath,
+    const std::function<Visitor*(size_t chunk_index)>& make_visitor,
+    const Options&                                     options)
+{
+    return detail::VisitFile(obj_filepath, make_visitor, options);
+}
+
+/// <summary>
+/// Quickly finds the number of elements in Wavefront geometry definition file (.obj file), without parsing it. Lines
+/// are only classified by their keyword, in parallel chunks, so the counts can be used to estimate the memory that
+/// ParseFile will need. Malformed lines are counted too and are not reported.
+/// </summary>
+/// <param name="obj_filepath"> : path of the .obj file to scan.</param>
+/// <param name="compute_bounds"> : if true, the positions are parsed to find their bounding box.</param>
+/// <param name="options"> : optional parsing options.</param>
+/// <returns>Element counts, material library name and bounds stored in ScanResult class.</returns>
+inline ScanResult ScanFile(const std::filesystem::path& obj_filepath, bool compute_bounds, const Options& options)
 {
-    return detail::Triangulate(result);
+    return detail::ScanFile(obj_filepath, compute_bounds, options);
 }
 
 } // namespace rapidobj
@@ -0,0 +1,162 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <fstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+static bool Equal(const Array<Index>& lhs, const Array<Index>& rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Index& a, const Index& b) {
+        return a.position_index == b.position_index && a.texcoord_index == b.texcoord_index &&
+               a.normal_index == b.normal_index;
+    });
+}
+
+static bool Equal(const TextureOption& lhs, const TextureOption& rhs)
+{
+    return lhs.type == rhs.type && lhs.sharpness == rhs.sharpness && lhs.brightness == rhs.brightness &&
+           lhs.contrast == rhs.contrast && lhs.origin_offset == rhs.origin_offset && lhs.scale == rhs.scale &&
+           lhs.turbulence == rhs.turbulence && lhs.texture_resolution == rhs.texture_resolution &&
+           lhs.clamp == rhs.clamp && lhs.imfchan == rhs.imfchan && lhs.blendu == rhs.blendu &&
+           lhs.blendv == rhs.blendv && lhs.bump_multiplier == rhs.bump_multiplier;
+}
+
+static bool Equal(const Material& lhs, const Material& rhs)
+{
+    return lhs.name == rhs.name && lhs.ambient == rhs.ambient && lhs.diffuse == rhs.diffuse &&
+           lhs.specular == rhs.specular && lhs.emission == rhs.emission && lhs.shininess == rhs.shininess &&
+           lhs.dissolve == rhs.dissolve && lhs.illum == rhs.illum && lhs.diffuse_texname == rhs.diffuse_texname &&
+           lhs.bump_texname == rhs.bump_texname && Equal(lhs.diffuse_texopt, rhs.diffuse_texopt) &&
+           Equal(lhs.bump_texopt, rhs.bump_texopt) && lhs.roughness == rhs.roughness &&
+           lhs.normal_texname == rhs.normal_texname && Equal(lhs.normal_texopt, rhs.normal_texopt);
+}
+
+static bool Equal(const Result& lhs, const Result& rhs)
+{
+    if (lhs.error.code != rhs.error.code) {
+        return false;
+    }
+    if (lhs.attributes.positions != rhs.attributes.positions || lhs.attributes.texcoords != rhs.attributes.texcoords ||
+        lhs.attributes.normals != rhs.attributes.normals || lhs.attributes.colors != rhs.attributes.colors) {
+        return false;
+    }
+    if (lhs.shapes.size() != rhs.shapes.size() || lhs.materials.size() != rhs.materials.size()) {
+        return false;
+    }
+    for (size_t i = 0; i != lhs.shapes.size(); ++i) {
+        const auto& a = lhs.shapes[i];
+        const auto& b = rhs.shapes[i];
+        if (a.name != b.name || !Equal(a.mesh.indices, b.mesh.indices) ||
+            a.mesh.num_face_vertices != b.mesh.num_face_vertices || a.mesh.material_ids != b.mesh.material_ids ||
+            a.mesh.smoothing_group_ids != b.mesh.smoothing_group_ids) {
+            return false;
+        }
+        if (!Equal(a.lines.indices, b.lines.indices) || a.lines.num_line_vertices != b.lines.num_line_vertices ||
+            !Equal(a.points.indices, b.points.indices)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i != lhs.materials.size(); ++i) {
+        if (!Equal(lhs.materials[i], rhs.materials[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("rapidobj::SaveBinary")
+{
+    auto binpath = std::filesystem::temp_directory_path() / "rapidobj_test_binary.bin";
+
+    auto objpaths = std::vector<std::filesystem::path>{
+        data_dir / "color" / "color.obj",   data_dir / "cube" / "cube.obj",
+        data_dir / "mario" / "mario.obj",   data_dir / "primitives" / "primitives.obj",
+        data_dir / "teapot" / "teapot.obj", data_dir / "mtllib" / "cube.obj"
+    };
+
+    SUBCASE("LoadBinary")
+    {
+        for (const auto& objpath : objpaths) {
+            auto expected = ParseFile(objpath, MaterialLibrary::Default(Load::Optional));
+
+            REQUIRE(!expected.error);
+            REQUIRE(!SaveBinary(expected, binpath));
+
+            auto actual = LoadBinary(binpath);
+
+            CHECK(!actual.error);
+            CHECK(Equal(expected, actual));
+        }
+    }
+
+    SUBCASE("Modify")
+    {
+        auto expected = ParseFile(data_dir / "teapot" / "teapot.obj");
+
+        REQUIRE(!SaveBinary(expected, binpath));
+
+        // writes to the loaded arrays do not reach the file
+        {
+            auto loaded = LoadBinary(binpath);
+
+            REQUIRE(!loaded.error);
+
+            std::fill(loaded.attributes.positions.begin(), loaded.attributes.positions.end(), 0.0f);
+
+            CHECK(Triangulate(loaded));
+        }
+
+        CHECK(Equal(expected, LoadBinary(binpath)));
+
+        // arrays keep the file mapped after the rest of the result is gone
+        auto positions = Array<float>();
+        {
+            auto loaded = LoadBinary(binpath);
+            positions   = std::move(loaded.attributes.positions);
+        }
+
+        CHECK(positions == expected.attributes.positions);
+    }
+
+    SUBCASE("Errors")
+    {
+        auto parsed = ParseFile(data_dir / "mario" / "mario.obj");
+
+        REQUIRE(!SaveBinary(parsed, binpath));
+
+        auto size = std::filesystem::file_size(binpath);
+
+        CHECK(LoadBinary(data_dir / "missing.bin").error);
+        CHECK(LoadBinary(data_dir / "mario" / "mario.obj").error.code == rapidobj_errc::BinaryFormatError);
+
+        std::filesystem::resize_file(binpath, size - 1);
+
+        CHECK(LoadBinary(binpath).error.code == rapidobj_errc::BinaryFormatError);
+
+        // unsupported version
+        REQUIRE(!SaveBinary(parsed, binpath));
+        {
+            auto file = std::fstream(binpath, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(8);
+            file.put(char(99));
+        }
+
+        CHECK(LoadBinary(binpath).error.code == rapidobj_errc::BinaryFormatError);
+
+        auto failed = ParseFile(data_dir / "missing.obj");
+
+        CHECK(SaveBinary(failed, binpath) == std::errc::invalid_argument);
+    }
+
+    std::filesystem::remove(binpath);
+}
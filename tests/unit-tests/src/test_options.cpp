@@ -0,0 +1,899 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <numeric>
+#include <set>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::string mario_objpath  = QUOTE(TEST_DATA_DIR) "/mario/mario.obj";
+static const std::string teapot_objpath = QUOTE(TEST_DATA_DIR) "/teapot/teapot.obj";
+
+static bool Equal(const Index& lhs, const Index& rhs)
+{
+    return lhs.position_index == rhs.position_index && lhs.texcoord_index == rhs.texcoord_index &&
+           lhs.normal_index == rhs.normal_index;
+}
+
+static bool Equal(const Array<Index>& lhs, const Array<Index>& rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i != lhs.size(); ++i) {
+        if (!Equal(lhs[i], rhs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool Equal(const Result& lhs, const Result& rhs)
+{
+    if (lhs.attributes.positions != rhs.attributes.positions || lhs.attributes.texcoords != rhs.attributes.texcoords ||
+        lhs.attributes.normals != rhs.attributes.normals || lhs.attributes.colors != rhs.attributes.colors) {
+        return false;
+    }
+    if (lhs.shapes.size() != rhs.shapes.size() || lhs.materials.size() != rhs.materials.size()) {
+        return false;
+    }
+    for (size_t i = 0; i != lhs.shapes.size(); ++i) {
+        const auto& a = lhs.shapes[i];
+        const auto& b = rhs.shapes[i];
+        if (a.name != b.name || !Equal(a.mesh.indices, b.mesh.indices) ||
+            a.mesh.num_face_vertices != b.mesh.num_face_vertices || a.mesh.material_ids != b.mesh.material_ids ||
+            a.mesh.smoothing_group_ids != b.mesh.smoothing_group_ids || !Equal(a.lines.indices, b.lines.indices) ||
+            a.lines.num_line_vertices != b.lines.num_line_vertices || !Equal(a.points.indices, b.points.indices)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i != lhs.materials.size(); ++i) {
+        if (lhs.materials[i].name != rhs.materials[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("rapidobj::Options::read")
+{
+    for (const auto& objpath : { mario_objpath, teapot_objpath }) {
+        auto expected = ParseFile(objpath);
+
+        REQUIRE(!expected.error);
+
+        SUBCASE("Read::Standard")
+        {
+            auto options = Options{};
+            options.read = Read::Standard;
+
+            auto result = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+        }
+
+        SUBCASE("Read::IoUring")
+        {
+            for (auto queue_depth : { size_t(0), size_t(1), size_t(2), size_t(4), size_t(32), size_t(1000) }) {
+                auto options        = Options{};
+                options.read        = Read::IoUring;
+                options.queue_depth = queue_depth;
+
+                auto result = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+
+        SUBCASE("Options::direct_io")
+        {
+            for (auto read : { Read::Standard, Read::IoUring }) {
+                auto options      = Options{};
+                options.read      = read;
+                options.direct_io = true;
+
+                auto result = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+
+        SUBCASE("Read::MemoryMap")
+        {
+            for (auto populate : { false, true }) {
+                auto options     = Options{};
+                options.read     = Read::MemoryMap;
+                options.populate = populate;
+
+                auto result = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+    }
+}
+
+// Writes a copy of mario.obj that is large enough to be parsed in parallel.
+static std::string WriteLargeObj(const char* filename)
+{
+    auto large_objpath = (std::filesystem::temp_directory_path() / filename).string();
+    auto src           = std::ifstream(mario_objpath, std::ios::binary);
+    auto dst           = std::ofstream(large_objpath, std::ios::binary);
+    auto obj           = std::string(std::istreambuf_iterator<char>(src), std::istreambuf_iterator<char>());
+
+    for (size_t i = 0; i != 3; ++i) {
+        dst << obj;
+    }
+
+    return large_objpath;
+}
+
+TEST_CASE("rapidobj::Options::thread_pool")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_thread_pool.obj");
+
+    // the large file is in a different directory from its .mtl file
+    auto mtllib = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    for (const auto& objpath : { mario_objpath, teapot_objpath, large_objpath }) {
+        auto expected = ParseFile(objpath, mtllib);
+
+        REQUIRE(!expected.error);
+
+        auto triangulated = ParseFile(objpath, mtllib);
+
+        REQUIRE(Triangulate(triangulated));
+
+        SUBCASE("ParseFile")
+        {
+            for (auto num_threads : { size_t(1), size_t(2), size_t(7) }) {
+                auto pool    = ThreadPool(num_threads);
+                auto options = Options{};
+
+                options.thread_pool = &pool;
+
+                CHECK(pool.Size() == num_threads);
+
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+
+        SUBCASE("ParseStream")
+        {
+            for (auto num_threads : { size_t(1), size_t(2), size_t(7) }) {
+                auto pool    = ThreadPool(num_threads);
+                auto options = Options{};
+
+                options.thread_pool = &pool;
+
+                auto stream = std::ifstream(objpath, std::ios::binary);
+                auto result = ParseStream(stream, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(result.attributes.positions == expected.attributes.positions);
+                REQUIRE(result.shapes.size() == expected.shapes.size());
+                for (size_t i = 0; i != result.shapes.size(); ++i) {
+                    CHECK(Equal(result.shapes[i].mesh.indices, expected.shapes[i].mesh.indices));
+                }
+            }
+        }
+
+        SUBCASE("Triangulate")
+        {
+            for (auto num_threads : { size_t(1), size_t(2), size_t(7) }) {
+                auto pool    = ThreadPool(num_threads);
+                auto options = Options{};
+
+                options.thread_pool = &pool;
+
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(Triangulate(result, options));
+                CHECK(Equal(triangulated, result));
+            }
+        }
+
+        SUBCASE("Shared")
+        {
+            // several threads share one pool
+            auto pool    = ThreadPool(2);
+            auto options = Options{};
+            auto results = std::vector<Result>(4);
+            auto threads = std::vector<std::thread>();
+
+            options.thread_pool = &pool;
+
+            for (auto& result : results) {
+                threads.emplace_back([&objpath, &mtllib, &options, &result] {
+                    result = ParseFile(objpath, mtllib, options);
+                    Triangulate(result, options);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            for (const auto& result : results) {
+                CHECK(!result.error);
+                CHECK(Equal(triangulated, result));
+            }
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::Options::max_threads")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_max_threads.obj");
+    auto mtllib        = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    auto expected = ParseFile(large_objpath, mtllib);
+
+    REQUIRE(!expected.error);
+
+    auto triangulated = ParseFile(large_objpath, mtllib);
+
+    REQUIRE(Triangulate(triangulated));
+
+    SUBCASE("max_threads")
+    {
+        for (auto max_threads : { size_t(1), size_t(2), size_t(3) }) {
+            auto options        = Options{};
+            options.max_threads = max_threads;
+
+            auto result = ParseFile(large_objpath, mtllib, options);
+
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+
+            auto stream = std::ifstream(large_objpath, std::ios::binary);
+            auto parsed = ParseStream(stream, mtllib, options);
+
+            CHECK(!parsed.error);
+            CHECK(parsed.attributes.positions == expected.attributes.positions);
+
+            CHECK(Triangulate(result, options));
+            CHECK(Equal(triangulated, result));
+        }
+    }
+
+    SUBCASE("cpu_affinity")
+    {
+        auto all_cpus = std::vector<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+
+        std::iota(all_cpus.begin(), all_cpus.end(), size_t(0));
+
+        // the last list contains CPUs that do not exist; they are ignored
+        for (auto cpus : { std::vector<size_t>{ 0 }, all_cpus, std::vector<size_t>{ 0, 4096, 100000 } }) {
+            auto options         = Options{};
+            options.cpu_affinity = cpus;
+
+            auto result = ParseFile(large_objpath, mtllib, options);
+
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+
+            auto stream = std::ifstream(large_objpath, std::ios::binary);
+            auto parsed = ParseStream(stream, mtllib, options);
+
+            CHECK(!parsed.error);
+            CHECK(parsed.attributes.positions == expected.attributes.positions);
+
+            CHECK(Triangulate(result, options));
+            CHECK(Equal(triangulated, result));
+
+            auto pool = ThreadPool(2, cpus);
+
+            options.thread_pool = &pool;
+
+            CHECK(Equal(expected, ParseFile(large_objpath, mtllib, options)));
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::Options::presize")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_presize.obj");
+    auto mtllib        = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    for (const auto& objpath : { mario_objpath, teapot_objpath, large_objpath }) {
+        auto expected = ParseFile(objpath, mtllib);
+
+        REQUIRE(!expected.error);
+
+        for (auto read : { Read::Standard, Read::MemoryMap }) {
+            for (auto max_threads : { size_t(1), size_t(3) }) {
+                auto options        = Options{};
+                options.read        = read;
+                options.max_threads = max_threads;
+                options.presize     = true;
+
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+// Counts the bytes that are currently allocated from it.
+class CountingResource final : public MemoryResource {
+  public:
+    void* Allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        m_bytes += bytes;
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    void Deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+    {
+        m_bytes -= bytes;
+        ::operator delete(pointer, std::align_val_t(alignment));
+    }
+
+    size_t Bytes() const noexcept { return m_bytes; }
+
+  private:
+    std::atomic_size_t m_bytes{};
+};
+
+template <typename T>
+static bool AllocatedFrom(const Array<T>& array, const MemoryResource* resource)
+{
+    return array.empty() || array.resource() == resource;
+}
+
+static bool AllocatedFrom(const Result& result, const MemoryResource* resource)
+{
+    const auto& attributes = result.attributes;
+    if (!AllocatedFrom(attributes.positions, resource) || !AllocatedFrom(attributes.texcoords, resource) ||
+        !AllocatedFrom(attributes.normals, resource) || !AllocatedFrom(attributes.colors, resource)) {
+        return false;
+    }
+    for (const auto& shape : result.shapes) {
+        if (!AllocatedFrom(shape.mesh.indices, resource) || !AllocatedFrom(shape.mesh.num_face_vertices, resource) ||
+            !AllocatedFrom(shape.mesh.material_ids, resource) ||
+            !AllocatedFrom(shape.mesh.smoothing_group_ids, resource) || !AllocatedFrom(shape.lines.indices, resource) ||
+            !AllocatedFrom(shape.lines.num_line_vertices, resource) || !AllocatedFrom(shape.points.indices, resource)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("rapidobj::Options::memory_resource")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_memory_resource.obj");
+    auto mtllib        = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    for (const auto& objpath : { mario_objpath, teapot_objpath, large_objpath }) {
+        auto expected = ParseFile(objpath, mtllib);
+
+        REQUIRE(!expected.error);
+        CHECK(AllocatedFrom(expected, nullptr));
+
+        auto resource = CountingResource();
+        auto options  = Options{};
+
+        options.memory_resource = &resource;
+
+        SUBCASE("ParseFile")
+        {
+            {
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+                CHECK(AllocatedFrom(result, &resource));
+                CHECK(resource.Bytes() > 0);
+            }
+            CHECK(resource.Bytes() == 0);
+        }
+
+        SUBCASE("ParseStream")
+        {
+            {
+                auto stream = std::ifstream(objpath, std::ios::binary);
+                auto result = ParseStream(stream, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(AllocatedFrom(result, &resource));
+                CHECK(resource.Bytes() > 0);
+            }
+            CHECK(resource.Bytes() == 0);
+        }
+
+        SUBCASE("Triangulate")
+        {
+            {
+                auto triangulated = ParseFile(objpath, mtllib);
+                auto result       = ParseFile(objpath, mtllib, options);
+
+                REQUIRE(Triangulate(triangulated));
+                CHECK(Triangulate(result, options));
+                CHECK(Equal(triangulated, result));
+                CHECK(AllocatedFrom(result, &resource));
+            }
+            CHECK(resource.Bytes() == 0);
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::Options::huge_pages")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_huge_pages.obj");
+    auto mtllib        = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    for (const auto& objpath : { mario_objpath, teapot_objpath, large_objpath }) {
+        auto expected = ParseFile(objpath, mtllib);
+
+        REQUIRE(!expected.error);
+
+        auto options = Options{};
+
+        options.huge_pages = true;
+
+        SUBCASE("ParseFile")
+        {
+            for (auto read : { Read::Standard, Read::MemoryMap }) {
+                options.read = read;
+
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+
+        SUBCASE("ParseStream")
+        {
+            auto stream = std::ifstream(objpath, std::ios::binary);
+            auto result = ParseStream(stream, mtllib, options);
+
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+        }
+
+        SUBCASE("Triangulate")
+        {
+            auto triangulated = ParseFile(objpath, mtllib);
+            auto result       = ParseFile(objpath, mtllib, options);
+
+            REQUIRE(Triangulate(triangulated));
+            CHECK(Triangulate(result, options));
+            CHECK(Equal(triangulated, result));
+        }
+
+        SUBCASE("memory_resource")
+        {
+            // a memory resource takes precedence for Result arrays
+            auto resource = CountingResource();
+
+            options.memory_resource = &resource;
+
+            {
+                auto result = ParseFile(objpath, mtllib, options);
+
+                CHECK(Equal(expected, result));
+                CHECK(AllocatedFrom(result, &resource));
+            }
+            CHECK(resource.Bytes() == 0);
+        }
+    }
+
+    SUBCASE("HugePageResource")
+    {
+        auto resource = detail::HugePageResource::Instance();
+
+        for (size_t size : { size_t(1000), size_t(5'000'000), size_t(20'000'000) }) {
+            auto data = static_cast<char*>(resource->Allocate(size, alignof(float)));
+
+            REQUIRE(data != nullptr);
+            CHECK(reinterpret_cast<uintptr_t>(data) % alignof(float) == 0);
+
+            std::fill_n(data, size, 'x');
+
+            CHECK(std::count(data, data + size, 'x') == static_cast<ptrdiff_t>(size));
+
+            resource->Deallocate(data, size, alignof(float));
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::Options::parser_context")
+{
+    auto large_objpath = WriteLargeObj("rapidobj_test_parser_context.obj");
+    auto mtllib        = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+    auto objpaths      = { large_objpath, mario_objpath, teapot_objpath, large_objpath };
+
+    auto context = ParserContext();
+    auto options = Options{};
+
+    options.parser_context = &context;
+
+    CHECK(context.Capacity() == 0);
+
+    SUBCASE("ParseFile")
+    {
+        for (auto read : { Read::Standard, Read::MemoryMap }) {
+            for (auto huge_pages : { false, true }) {
+                for (const auto& objpath : objpaths) {
+                    options.read       = read;
+                    options.huge_pages = huge_pages;
+
+                    auto expected = ParseFile(objpath, mtllib);
+                    auto result   = ParseFile(objpath, mtllib, options);
+
+                    CHECK(!result.error);
+                    CHECK(Equal(expected, result));
+                    CHECK(context.Capacity() > 0);
+                }
+            }
+        }
+    }
+
+    SUBCASE("ParseStream")
+    {
+        for (auto max_threads : { size_t(1), size_t(3) }) {
+            for (const auto& objpath : objpaths) {
+                options.max_threads = max_threads;
+
+                auto expected_stream = std::ifstream(objpath, std::ios::binary);
+                auto actual_stream   = std::ifstream(objpath, std::ios::binary);
+
+                auto expected = ParseStream(expected_stream, mtllib);
+                auto result   = ParseStream(actual_stream, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+                CHECK(context.Capacity() > 0);
+            }
+        }
+    }
+
+    SUBCASE("Shared")
+    {
+        // calls that find the context in use parse with their own buffers
+        auto expected = ParseFile(large_objpath, mtllib);
+        auto results  = std::vector<Result>(4);
+        auto threads  = std::vector<std::thread>();
+
+        for (auto& result : results) {
+            threads.emplace_back([&] { result = ParseFile(large_objpath, mtllib, options); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (const auto& result : results) {
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+        }
+    }
+
+    SUBCASE("Clear")
+    {
+        auto result = ParseFile(large_objpath, mtllib, options);
+
+        CHECK(!result.error);
+        CHECK(context.Capacity() > 0);
+
+        context.Clear();
+
+        CHECK(context.Capacity() == 0);
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::FlushDeferredFrees")
+{
+    struct Garbage final {
+        explicit Garbage(std::atomic<size_t>* counter) noexcept : counter(counter) {}
+        Garbage(Garbage&& other) noexcept : counter(std::exchange(other.counter, nullptr)) {}
+        ~Garbage()
+        {
+            if (counter) {
+                ++*counter;
+            }
+        }
+        std::atomic<size_t>* counter;
+    };
+
+    auto freed = std::atomic<size_t>(0);
+
+    // more than the queue holds; the rest are freed on this thread
+    for (size_t i = 0; i != 3 * detail::kMaxDeferredFrees; ++i) {
+        detail::DeferredFreeQueue::Instance().Push(Garbage(&freed));
+    }
+
+    FlushDeferredFrees();
+
+    CHECK(freed == 3 * detail::kMaxDeferredFrees);
+
+    // memory freed by Triangulate goes through the same queue
+    auto result = ParseFile(mario_objpath);
+
+    CHECK(!result.error);
+    CHECK(Triangulate(result));
+
+    FlushDeferredFrees();
+}
+
+TEST_CASE("rapidobj::Options::cache_directory")
+{
+    auto cache_directory = std::filesystem::temp_directory_path() / "rapidobj_test_cache";
+    auto large_objpath   = WriteLargeObj("rapidobj_test_cache.obj");
+    auto mtllib          = MaterialLibrary::SearchPath(std::filesystem::path(mario_objpath).parent_path());
+
+    std::filesystem::remove_all(cache_directory);
+
+    auto options = Options{};
+
+    options.cache_directory = cache_directory;
+
+    auto num_cache_files = [&cache_directory]() {
+        auto files = std::filesystem::directory_iterator(cache_directory);
+        return std::distance(begin(files), end(files));
+    };
+
+    SUBCASE("ParseFile")
+    {
+        for (const auto& objpath : { mario_objpath, teapot_objpath, large_objpath }) {
+            auto expected = ParseFile(objpath, mtllib);
+            auto parsed   = ParseFile(objpath, mtllib, options); // parsed and stored in the cache
+            auto cached   = ParseFile(objpath, mtllib, options); // loaded from the cache
+
+            CHECK(!parsed.error);
+            CHECK(!cached.error);
+            CHECK(Equal(expected, parsed));
+            CHECK(Equal(expected, cached));
+            CHECK(parsed.attributes.positions.resource() == nullptr);
+            CHECK(cached.attributes.positions.resource() != nullptr);
+        }
+
+        CHECK(num_cache_files() == 3);
+    }
+
+    SUBCASE("ParseFiles")
+    {
+        auto objpaths = std::vector<std::filesystem::path>{ mario_objpath, teapot_objpath, large_objpath };
+        auto expected = ParseFiles(objpaths, mtllib);
+        auto parsed   = ParseFiles(objpaths, mtllib, options);
+        auto cached   = ParseFiles(objpaths, mtllib, options);
+
+        for (size_t i = 0; i != objpaths.size(); ++i) {
+            CHECK(Equal(expected[i], parsed[i]));
+            CHECK(Equal(expected[i], cached[i]));
+        }
+
+        CHECK(num_cache_files() == 3);
+    }
+
+    SUBCASE("MaterialLibrary")
+    {
+        // the cache is keyed by the contents of the .mtl file and by the material library argument
+        auto directory = std::filesystem::temp_directory_path() / "rapidobj_test_cache_mtl";
+        auto objpath   = directory / "mario.obj";
+        auto mtlpath   = directory / "Mario.mtl";
+
+        std::filesystem::create_directories(directory);
+        std::filesystem::copy_file(mario_objpath, objpath, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::copy_file(
+            std::filesystem::path(mario_objpath).parent_path() / "Mario.mtl",
+            mtlpath,
+            std::filesystem::copy_options::overwrite_existing);
+
+        auto before = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+        std::ofstream(mtlpath, std::ios::app) << "newmtl Unused\n";
+
+        auto after   = ParseFile(objpath, MaterialLibrary::Default(), options);
+        auto ignored = ParseFile(objpath, MaterialLibrary::Ignore(), options);
+
+        CHECK(!before.error);
+        CHECK(!after.error);
+        CHECK(!ignored.error);
+        CHECK(after.materials.size() == before.materials.size() + 1);
+        CHECK(ignored.materials.empty());
+        CHECK(num_cache_files() == 3);
+
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::remove_all(cache_directory);
+    std::filesystem::remove(large_objpath);
+}
+
+TEST_CASE("rapidobj::Options::shape_filter")
+{
+    // a file with many shapes, large enough to be parsed in parallel; the first face is not in any named shape
+    auto large_objpath = (std::filesystem::temp_directory_path() / "rapidobj_test_shape_filter.obj").string();
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        dst << "mtllib materials.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+        for (size_t i = 0; i != 20000; ++i) {
+            dst << "o shape" << i % 7 << "\nv " << i << " 0 0\nv 0 " << i << " 0\nv 0 0 " << i << "\n";
+            dst << "usemtl Material" << i % 3 << "\ns " << i % 2 << "\n";
+            dst << "f -3 -2 -1\nf " << 3 * i + 4 << " " << 3 * i + 5 << " " << 3 * i + 6 << "\nl -1 -2\np -1\n";
+        }
+    }
+
+    auto mtllib = MaterialLibrary::String("newmtl Material0\nnewmtl Material1\nnewmtl Material2\n");
+    auto all    = ParseFile(large_objpath, mtllib);
+
+    REQUIRE(!all.error);
+    REQUIRE(all.shapes.size() == 20001);
+
+    for (auto names : { std::set<std::string>{ "shape1", "shape4" }, std::set<std::string>{ "", "shape6" } }) {
+        auto options = Options{};
+
+        options.shape_filter = [&names](std::string_view name) { return names.count(std::string(name)) != 0; };
+
+        // the same result, without the rejected shapes
+        auto expected = ParseFile(large_objpath, mtllib);
+        auto rejected = [&names](const Shape& shape) { return names.count(shape.name) == 0; };
+
+        expected.shapes.erase(
+            std::remove_if(expected.shapes.begin(), expected.shapes.end(), rejected), expected.shapes.end());
+
+        SUBCASE("ParseFile")
+        {
+            for (auto num_threads : { size_t(1), size_t(3) }) {
+                auto pool = ThreadPool(num_threads);
+
+                options.thread_pool = &pool;
+
+                auto result = ParseFile(large_objpath, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+
+        SUBCASE("ParseStream")
+        {
+            auto stream = std::ifstream(large_objpath, std::ios::binary);
+            auto result = ParseStream(stream, mtllib, options);
+
+            CHECK(!result.error);
+            CHECK(Equal(expected, result));
+        }
+
+        SUBCASE("ParseFileSegmented")
+        {
+            auto result = ParseFileSegmented(large_objpath, mtllib, options);
+
+            CHECK(!result.error);
+            REQUIRE(result.shapes.size() == expected.shapes.size());
+            for (size_t i = 0; i != expected.shapes.size(); ++i) {
+                CHECK(result.shapes[i].name == expected.shapes[i].name);
+                CHECK(result.shapes[i].mesh.material_ids == expected.shapes[i].mesh.material_ids);
+            }
+        }
+
+        SUBCASE("cache_directory")
+        {
+            auto cache_directory = std::filesystem::temp_directory_path() / "rapidobj_test_shape_filter_cache";
+
+            options.cache_directory = cache_directory;
+
+            auto parsed = ParseFile(large_objpath, mtllib, options); // parsed and stored in the cache
+            auto cached = ParseFile(large_objpath, mtllib, options); // loaded from the cache
+
+            options.shape_filter = {};
+
+            CHECK(Equal(expected, parsed));
+            CHECK(Equal(expected, cached));
+            CHECK(Equal(all, ParseFile(large_objpath, mtllib, options))); // the cache holds all shapes
+
+            std::filesystem::remove_all(cache_directory);
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
+
+// Removes the attributes that are skipped from a fully parsed result.
+static Result WithoutAttributes(Result result, const Options& options)
+{
+    if (options.skip_texcoords) {
+        result.attributes.texcoords = Array<float>();
+    }
+    if (options.skip_normals) {
+        result.attributes.normals = Array<float>();
+    }
+    if (options.skip_colors) {
+        result.attributes.colors = Array<float>();
+    }
+    for (auto& shape : result.shapes) {
+        for (auto* indices : { &shape.mesh.indices, &shape.lines.indices }) {
+            for (auto& index : *indices) {
+                index.texcoord_index = options.skip_texcoords ? -1 : index.texcoord_index;
+                index.normal_index   = options.skip_normals ? -1 : index.normal_index;
+            }
+        }
+    }
+    return result;
+}
+
+TEST_CASE("rapidobj::Options::skip_attributes")
+{
+    // a file with vertex colors and relative indices, large enough to be parsed in parallel
+    auto large_objpath = (std::filesystem::temp_directory_path() / "rapidobj_test_skip_attributes.obj").string();
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        for (size_t i = 0; i != 20000; ++i) {
+            dst << "v " << i << " 0 0 1 0 0\nv 0 " << i << " 0 0 1 0\nv 0 0 " << i << " 0 0 1\nvn 0 0 1\nvt 0.5 0.5\n";
+            dst << "f -3/-1/-1 -2/-1/-1 -1/-1/-1\nf " << 3 * i + 1 << "/" << i + 1 << " " << 3 * i + 2 << "//1 ";
+            dst << 3 * i + 3 << "\nl -1/-1 -2/-1\n";
+        }
+    }
+
+    auto color_objpath = std::string(QUOTE(TEST_DATA_DIR) "/color/color.obj");
+
+    for (const auto& objpath : { mario_objpath, teapot_objpath, color_objpath, large_objpath }) {
+        for (auto mask : { 1, 2, 4, 7 }) {
+            auto options = Options{};
+
+            options.skip_texcoords = mask & 1;
+            options.skip_normals   = mask & 2;
+            options.skip_colors    = mask & 4;
+
+            auto expected = WithoutAttributes(ParseFile(objpath), options);
+
+            REQUIRE(!expected.error);
+
+            SUBCASE("ParseFile")
+            {
+                for (auto presize : { false, true }) {
+                    auto pool = ThreadPool(3);
+
+                    options.thread_pool = &pool;
+                    options.presize     = presize;
+
+                    auto result = ParseFile(objpath, MaterialLibrary::Default(), options);
+
+                    CHECK(!result.error);
+                    CHECK(Equal(expected, result));
+                }
+            }
+
+            SUBCASE("ParseStream")
+            {
+                auto stream = std::ifstream(objpath, std::ios::binary);
+                auto mtllib = MaterialLibrary::SearchPath(std::filesystem::path(objpath).parent_path());
+                auto result = ParseStream(stream, mtllib, options);
+
+                CHECK(!result.error);
+                CHECK(Equal(expected, result));
+            }
+        }
+    }
+
+    std::filesystem::remove(large_objpath);
+}
@@ -0,0 +1,121 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <fstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+static bool Equal(const Array<Index>& lhs, const Array<Index>& rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Index& a, const Index& b) {
+        return a.position_index == b.position_index && a.texcoord_index == b.texcoord_index &&
+               a.normal_index == b.normal_index;
+    });
+}
+
+static bool Equal(const Result& lhs, const Result& rhs)
+{
+    if (lhs.error.code != rhs.error.code || lhs.error.line_num != rhs.error.line_num) {
+        return false;
+    }
+    if (lhs.attributes.positions != rhs.attributes.positions || lhs.attributes.texcoords != rhs.attributes.texcoords ||
+        lhs.attributes.normals != rhs.attributes.normals || lhs.attributes.colors != rhs.attributes.colors) {
+        return false;
+    }
+    if (lhs.shapes.size() != rhs.shapes.size() || lhs.materials.size() != rhs.materials.size()) {
+        return false;
+    }
+    for (size_t i = 0; i != lhs.shapes.size(); ++i) {
+        const auto& a = lhs.shapes[i];
+        const auto& b = rhs.shapes[i];
+        if (a.name != b.name || !Equal(a.mesh.indices, b.mesh.indices) ||
+            a.mesh.num_face_vertices != b.mesh.num_face_vertices || a.mesh.material_ids != b.mesh.material_ids) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i != lhs.materials.size(); ++i) {
+        if (lhs.materials[i].name != rhs.materials[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("rapidobj::ParseFiles")
+{
+    // a copy of mario.obj that is large enough to be parsed in parallel
+    auto large_objpath = std::filesystem::temp_directory_path() / "rapidobj_test_parse_files.obj";
+
+    {
+        auto src = std::ifstream(data_dir / "mario" / "mario.obj", std::ios::binary);
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        auto obj = std::string(std::istreambuf_iterator<char>(src), std::istreambuf_iterator<char>());
+        for (size_t i = 0; i != 3; ++i) {
+            dst << obj;
+        }
+    }
+
+    auto filepaths = std::vector<std::filesystem::path>{
+        data_dir / "color" / "color.obj",  data_dir / "teapot" / "teapot.obj",
+        data_dir / "mario" / "mario.obj",  data_dir / "missing.obj",
+        large_objpath,                     data_dir / "mtllib" / "cube.obj",
+        data_dir / "teapot" / "teapot.obj"
+    };
+
+    auto mtllib = MaterialLibrary::SearchPaths({ ".", data_dir / "mario" }, Load::Optional);
+
+    auto expected = std::vector<Result>();
+
+    for (const auto& filepath : filepaths) {
+        expected.push_back(ParseFile(filepath, mtllib));
+    }
+
+    REQUIRE(expected[3].error.code == std::errc::no_such_file_or_directory);
+
+    SUBCASE("Default")
+    {
+        auto results = ParseFiles(filepaths, mtllib);
+
+        REQUIRE(results.size() == filepaths.size());
+        for (size_t i = 0; i != results.size(); ++i) {
+            CHECK(Equal(expected[i], results[i]));
+        }
+    }
+
+    SUBCASE("Options")
+    {
+        for (auto max_threads : { size_t(1), size_t(3) }) {
+            auto pool    = ThreadPool(3);
+            auto options = Options{};
+
+            options.max_threads = max_threads;
+
+            for (auto thread_pool : { static_cast<ThreadPool*>(nullptr), &pool }) {
+                options.thread_pool = thread_pool;
+
+                auto results = ParseFiles(filepaths, mtllib, options);
+
+                REQUIRE(results.size() == filepaths.size());
+                for (size_t i = 0; i != results.size(); ++i) {
+                    CHECK(Equal(expected[i], results[i]));
+                }
+            }
+        }
+    }
+
+    SUBCASE("Empty")
+    {
+        CHECK(ParseFiles({}).empty());
+    }
+
+    std::filesystem::remove(large_objpath);
+}
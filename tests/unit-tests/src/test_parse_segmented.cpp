@@ -0,0 +1,143 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <fstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+template <typename T>
+static std::vector<T> Concatenate(const Segments<T>& segments)
+{
+    auto result = std::vector<T>();
+    for (const auto& segment : segments) {
+        result.insert(result.end(), segment.begin(), segment.end());
+    }
+    return result;
+}
+
+template <typename T>
+static bool Equal(const Array<T>& lhs, const Segments<T>& rhs)
+{
+    auto concatenated = Concatenate(rhs);
+    return std::equal(lhs.begin(), lhs.end(), concatenated.begin(), concatenated.end());
+}
+
+static bool Equal(const Array<Index>& lhs, const Segments<Index>& rhs)
+{
+    auto concatenated = Concatenate(rhs);
+    return std::equal(lhs.begin(), lhs.end(), concatenated.begin(), concatenated.end(), [](auto& a, auto& b) {
+        return a.position_index == b.position_index && a.texcoord_index == b.texcoord_index &&
+               a.normal_index == b.normal_index;
+    });
+}
+
+static bool Equal(const Result& lhs, const SegmentedResult& rhs)
+{
+    if (lhs.error.code != rhs.error.code || lhs.error.line_num != rhs.error.line_num) {
+        return false;
+    }
+    const auto& a = lhs.attributes;
+    const auto& b = rhs.attributes;
+    if (!Equal(a.positions, b.positions) || !Equal(a.texcoords, b.texcoords) || !Equal(a.normals, b.normals) ||
+        !Equal(a.colors, b.colors)) {
+        return false;
+    }
+    if (lhs.shapes.size() != rhs.shapes.size() || lhs.materials.size() != rhs.materials.size()) {
+        return false;
+    }
+    for (size_t i = 0; i != lhs.shapes.size(); ++i) {
+        const auto& a = lhs.shapes[i];
+        const auto& b = rhs.shapes[i];
+        if (a.name != b.name || !Equal(a.mesh.indices, b.mesh.indices) ||
+            !Equal(a.mesh.num_face_vertices, b.mesh.num_face_vertices) ||
+            a.mesh.material_ids != b.mesh.material_ids || a.mesh.smoothing_group_ids != b.mesh.smoothing_group_ids) {
+            return false;
+        }
+        if (!Equal(a.lines.indices, b.lines.indices) || !Equal(a.lines.num_line_vertices, b.lines.num_line_vertices) ||
+            !Equal(a.points.indices, b.points.indices)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i != lhs.materials.size(); ++i) {
+        if (lhs.materials[i].name != rhs.materials[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("rapidobj::ParseFileSegmented")
+{
+    // a file with shapes, materials, smoothing groups, vertex colors and relative indices, that is large enough to be
+    // split into several chunks
+    auto large_objpath = std::filesystem::temp_directory_path() / "rapidobj_test_parse_segmented.obj";
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        dst << "mtllib materials.mtl\n";
+        for (size_t i = 0; i != 20000; ++i) {
+            dst << "o shape" << i % 7 << "\n";
+            dst << "v " << i << " 0 0 1 0 0\nv 0 " << i << " 0 0 1 0\nv 0 0 " << i << " 0 0 1\nvn 0 0 1\nvt 0.5 0.5\n";
+            dst << "usemtl Material" << i % 3 << "\ns " << i % 2 << "\n";
+            dst << "f -3/-1/-1 -2/-1/-1 -1/-1/-1\nf " << 3 * i + 1 << " " << 3 * i + 2 << " " << 3 * i + 3 << "\n";
+            dst << "l -1 -2\np " << 3 * i + 1 << "\n";
+        }
+    }
+
+    auto filepaths = std::vector<std::filesystem::path>{
+        data_dir / "color" / "color.obj",    data_dir / "teapot" / "teapot.obj", data_dir / "mario" / "mario.obj",
+        data_dir / "primitives" / "primitives.obj", data_dir / "missing.obj",    large_objpath
+    };
+
+    auto mtllib = MaterialLibrary::String("newmtl Material0\nnewmtl Material1\nnewmtl Material2\n");
+
+    SUBCASE("ParseFile")
+    {
+        for (const auto& filepath : filepaths) {
+            auto expected = ParseFile(filepath, mtllib);
+            auto actual   = ParseFileSegmented(filepath, mtllib);
+
+            CHECK(Equal(expected, actual));
+            CHECK((actual.error || actual.storage));
+        }
+    }
+
+    SUBCASE("ParseStream")
+    {
+        for (const auto& filepath : filepaths) {
+            auto expected_stream = std::ifstream(filepath, std::ios::binary);
+            auto actual_stream   = std::ifstream(filepath, std::ios::binary);
+
+            auto expected = ParseStream(expected_stream, mtllib);
+            auto actual   = ParseStreamSegmented(actual_stream, mtllib);
+
+            CHECK(Equal(expected, actual));
+        }
+    }
+
+    SUBCASE("ThreadPool")
+    {
+        auto pool    = ThreadPool(3);
+        auto options = Options{};
+
+        options.thread_pool = &pool;
+
+        auto expected = ParseFile(large_objpath, mtllib, options);
+        auto actual   = ParseFileSegmented(large_objpath, mtllib, options);
+
+        CHECK(!actual.error);
+        CHECK(actual.attributes.positions.size() > 1);
+        CHECK(Equal(expected, actual));
+    }
+
+    std::filesystem::remove(large_objpath);
+}
@@ -118,6 +118,26 @@ TEST_CASE("rapidobj::detail::ParseReals")
     }
 }
 
+TEST_CASE("rapidobj::detail::ParseIndex")
+{
+    // must accept exactly what std::from_chars accepts
+    for (auto text : { "1", "-1", "0", "-0", "", "-", "+1", "/1", "12/3", "7 8", "123456789", "1234567890",
+                       "2147483647", "2147483648", "-2147483648", "-2147483649", "0000000000001",
+                       "99999999999999999999", "5x" }) {
+        auto view     = std::string_view(text);
+        auto expected = 0;
+        auto actual   = 0;
+        auto result   = std::from_chars(view.data(), view.data() + view.size(), expected);
+        auto ptr      = ParseIndex(view.data(), view.data() + view.size(), &actual);
+        if (result.ec == std::errc()) {
+            CHECK(ptr == result.ptr);
+            CHECK(actual == expected);
+        } else {
+            CHECK(ptr == nullptr);
+        }
+    }
+}
+
 TEST_CASE("rapidobj::detail::ParseFace")
 {
     auto indices = Buffer<Index>();
@@ -134,9 +154,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 1, -1, -1 });
         CHECK(indices.data()[2] == Index{ 2, -1, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -151,10 +169,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[2] == Index{ 2, -1, -1 });
         CHECK(indices.data()[3] == Index{ 3, -1, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
-        CHECK(flags.data()[3] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -184,8 +199,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[0] == Index{ 0, -1, -1 });
         CHECK(indices.data()[254] == Index{ 254, -1, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[254] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -231,9 +245,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 42, -1, -1 });
         CHECK(indices.data()[2] == Index{ 43, -1, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -247,9 +259,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 0, -1, -1 });
         CHECK(indices.data()[2] == Index{ 0, -1, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -263,9 +273,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 43, 44, -1 });
         CHECK(indices.data()[2] == Index{ 45, 46, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -280,10 +288,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[2] == Index{ 45, 46, -1 });
         CHECK(indices.data()[3] == Index{ 47, 48, -1 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
-        CHECK(flags.data()[3] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -345,9 +350,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 3, 4, 5 });
         CHECK(indices.data()[2] == Index{ 6, 7, 8 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -362,10 +365,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[2] == Index{ 6, 7, 8 });
         CHECK(indices.data()[3] == Index{ 9, 10, 11 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
-        CHECK(flags.data()[3] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -508,9 +508,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[1] == Index{ 3, -1, 4 });
         CHECK(indices.data()[2] == Index{ 5, -1, 6 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -525,10 +523,7 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(indices.data()[2] == Index{ 5, -1, 6 });
         CHECK(indices.data()[3] == Index{ 7, -1, 8 });
 
-        CHECK(flags.data()[0] == ApplyOffset::None);
-        CHECK(flags.data()[1] == ApplyOffset::None);
-        CHECK(flags.data()[2] == ApplyOffset::None);
-        CHECK(flags.data()[3] == ApplyOffset::None);
+        CHECK(flags.size() == 0);
     }
 
     SUBCASE("")
@@ -819,4 +814,152 @@ TEST_CASE("rapidobj::detail::ParseFace")
         CHECK(count == 0);
         CHECK(ec == rapidobj_errc::ParseError);
     }
+
+    SUBCASE("")
+    {
+        // offset flags are back-filled once the first relative index is seen
+        auto [count1, ec1] = ParseFace("1 2 3", 0, 0, 0, 3, 255, kAllowAll, &indices, &flags);
+        auto [count2, ec2] = ParseFace("1/1 -1/2 3/-3", 3, 3, 0, 3, 255, kAllowAll, &indices, &flags);
+        auto [count3, ec3] = ParseFace("4 5 6", 0, 0, 0, 3, 255, kAllowAll, &indices, &flags);
+
+        CHECK(count1 + count2 + count3 == 9);
+        CHECK(ec1 == rapidobj_errc());
+        CHECK(ec2 == rapidobj_errc());
+        CHECK(ec3 == rapidobj_errc());
+
+        CHECK(indices.size() == 9);
+        CHECK(indices.data()[4] == Index{ 2, 1, -1 });
+        CHECK(indices.data()[5] == Index{ 2, 0, -1 });
+
+        REQUIRE(flags.size() == 9);
+        CHECK(flags.data()[0] == ApplyOffset::None);
+        CHECK(flags.data()[2] == ApplyOffset::None);
+        CHECK(flags.data()[3] == ApplyOffset::None);
+        CHECK(flags.data()[4] == ApplyOffset::Position);
+        CHECK(flags.data()[5] == ApplyOffset::Texcoord);
+        CHECK(flags.data()[8] == ApplyOffset::None);
+    }
+
+    SUBCASE("")
+    {
+        // without offset flags, relative indices are resolved in place; -1 must not be mistaken for a missing index
+        auto [count, ec] = ParseFace("-1/-1/-2 -2/-2/-1 3/-3/-3", 3, 2, 2, 3, 255, kAllowAll, &indices, nullptr);
+
+        CHECK(count == 3);
+        CHECK(ec == rapidobj_errc());
+
+        CHECK(indices.data()[0] == Index{ 2, 1, 0 });
+        CHECK(indices.data()[1] == Index{ 1, 0, 1 });
+        CHECK(indices.data()[2] == Index{ 2, kInvalidIndex, kInvalidIndex });
+    }
+}
+
+TEST_CASE("rapidobj::detail::NewlineIndex")
+{
+    // a window larger than kBlockSize, with runs of newlines, long lines and lines straddling 64-byte words
+    auto text = std::string();
+
+    for (size_t i = 0; text.size() < kBlockSize + 3 * kMaxLineLength; ++i) {
+        text.append(i % 97 == 0 ? 3 * i % kMaxLineLength : i % 71, 'x');
+        text.append(i % 13 == 0 ? 3 : 1, '\n');
+    }
+
+    SUBCASE("kernels")
+    {
+        using Kernel = void (*)(const char*, size_t, uint64_t*) noexcept;
+
+        auto kernels = std::vector<Kernel>{ GetNewlineKernel().function };
+
+#if defined(__x86_64__) || defined(_M_X64)
+        kernels.push_back(IndexNewlinesSse2);
+        if (CpuSupportsAvx2()) {
+            kernels.push_back(IndexNewlinesAvx2);
+        }
+#endif
+
+        for (auto size : { size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(1000), kBlockSize }) {
+            for (auto offset : { size_t(0), size_t(1), size_t(33) }) {
+                auto expected = std::vector<uint64_t>(kBlockSize / 64 + 1);
+                auto actual   = std::vector<uint64_t>(kBlockSize / 64 + 1);
+
+                IndexNewlinesScalar(text.data() + offset, size, expected.data());
+
+                for (auto kernel : kernels) {
+                    std::fill(actual.begin(), actual.end(), ~uint64_t{});
+                    kernel(text.data() + offset, size, actual.data());
+                    auto words = (size + 63) / 64;
+                    CHECK(std::equal(actual.begin(), actual.begin() + words, expected.begin()));
+                }
+            }
+        }
+    }
+
+    SUBCASE("Find")
+    {
+        auto newlines = NewlineIndex();
+
+        // walk the text line by line, the same way the parser does
+        for (auto size : { text.size(), kBlockSize, size_t(100) }) {
+            newlines.Reset();
+            auto remaining = std::string_view(text.data(), size);
+            while (!remaining.empty()) {
+                auto expected = static_cast<const char*>(memchr(remaining.data(), '\n', remaining.size()));
+                auto actual   = newlines.Find(remaining.data(), remaining.size());
+                REQUIRE(actual == expected);
+                remaining.remove_prefix(actual ? static_cast<size_t>(actual - remaining.data()) + 1 : remaining.size());
+            }
+        }
+
+        // search ranges that end before the next newline
+        newlines.Reset();
+        for (size_t pos = 0; pos < text.size(); pos += 4099) {
+            for (auto size : { size_t(0), size_t(1), size_t(17), size_t(200) }) {
+                size = std::min(size, text.size() - pos);
+                CHECK(newlines.Find(text.data() + pos, size) == memchr(text.data() + pos, '\n', size));
+            }
+        }
+    }
+}
+
+TEST_CASE("rapidobj::detail::FromChars")
+{
+    // the fast path must agree with fast_float bit for bit and stop at the same character
+    auto check = [](std::string_view text) {
+        auto expected = 0.0f;
+        auto actual   = 0.0f;
+        auto result   = fast_float::from_chars(text.data(), text.data() + text.size(), expected);
+        auto [ptr, ec] = FromChars(text.data(), text.data() + text.size(), actual);
+        REQUIRE(ec == result.ec);
+        if (ec == std::errc()) {
+            CHECK(ptr == result.ptr);
+            CHECK(std::memcmp(&expected, &actual, sizeof(float)) == 0);
+        }
+    };
+
+    for (auto text : { "0", "-0", "1", "1.", ".5", "-.5", "-", ".", "-.", "", " 1", "+1", "1e5", "1.5E-3", "1.5e",
+                       "inf", "-nan", "0.000000001", "12345678", "1234567.8", "16777216", "16777217", "1.6777217",
+                       "0.16777217", "1099511693312", "00000000000001.5", "1.25 2.5", "3.75/", "9.999999999",
+                       "-0.00000000" }) {
+        check(text);
+    }
+
+    for (auto digits = 1; digits <= 10; ++digits) {
+        for (auto fraction = 0; fraction <= 9; ++fraction) {
+            for (auto seed : { 1u, 7u, 123456789u, 4294967295u }) {
+                auto text = std::string(seed % 2 ? "-" : "");
+                for (auto i = 0; i != digits; ++i) {
+                    text += static_cast<char>('0' + (seed >> (3 * i % 29)) % 10);
+                }
+                if (fraction > 0) {
+                    text += '.';
+                    for (auto i = 0; i != fraction; ++i) {
+                        text += static_cast<char>('0' + (seed >> (5 * i % 27)) % 10);
+                    }
+                }
+                check(text);
+                check(text + " 1");
+                check(text + "e1");
+            }
+        }
+    }
 }
@@ -0,0 +1,145 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <fstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+static void Check(const std::filesystem::path& filepath, const Options& options)
+{
+    auto scan     = ScanFile(filepath, true, options);
+    auto expected = ParseFile(filepath, MaterialLibrary::Ignore(), options);
+
+    REQUIRE(!scan.error);
+    REQUIRE(!expected.error);
+
+    auto num_faces  = size_t{};
+    auto num_lines  = size_t{};
+    auto num_points = size_t{};
+
+    for (const auto& shape : expected.shapes) {
+        num_faces += shape.mesh.num_face_vertices.size();
+        num_lines += shape.lines.num_line_vertices.size();
+        num_points += shape.points.indices.size();
+    }
+
+    CHECK(scan.num_positions == expected.attributes.positions.size() / 3);
+    CHECK(scan.num_texcoords == expected.attributes.texcoords.size() / 2);
+    CHECK(scan.num_normals == expected.attributes.normals.size() / 3);
+    CHECK(scan.num_faces == num_faces);
+    CHECK(scan.num_lines == num_lines);
+    CHECK(scan.num_points <= num_points); // a p statement may list several points
+
+    auto min = std::array<float, 3>{ FLT_MAX, FLT_MAX, FLT_MAX };
+    auto max = std::array<float, 3>{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    const auto& positions = expected.attributes.positions;
+
+    for (size_t i = 0; i != positions.size(); ++i) {
+        min[i % 3] = std::min(min[i % 3], positions[i]);
+        max[i % 3] = std::max(max[i % 3], positions[i]);
+    }
+
+    CHECK(scan.min == min);
+    CHECK(scan.max == max);
+}
+
+TEST_CASE("rapidobj::ScanFile")
+{
+    // a file with shapes, vertex colors and relative indices, that is large enough to be split into several chunks
+    auto large_objpath = std::filesystem::temp_directory_path() / "rapidobj_test_scan_file.obj";
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        dst << "mtllib materials.mtl\n";
+        for (size_t i = 0; i != 20000; ++i) {
+            dst << "o shape" << i % 7 << "\n";
+            dst << "v " << i << " 0 0 1 0 0\nv 0 -" << i << " 0\nv 0 0 " << i << "\nvn 0 0 1\nvt 0.5 0.5\n";
+            dst << "usemtl Material" << i % 3 << "\ns " << i % 2 << "\n";
+            dst << "f -3/-1/-1 -2/-1/-1 -1/-1/-1\nf " << 3 * i + 1 << " " << 3 * i + 2 << " " << 3 * i + 3 << "\n";
+            dst << "l -1 -2\np " << 3 * i + 1 << "\n";
+        }
+        dst << "mtllib other.mtl\n";
+    }
+
+    auto filepaths = std::vector<std::filesystem::path>{
+        data_dir / "cube" / "cube.obj",   data_dir / "mario" / "mario.obj", data_dir / "primitives" / "primitives.obj",
+        data_dir / "teapot" / "teapot.obj", large_objpath
+    };
+
+    SUBCASE("ParseFile")
+    {
+        for (const auto& filepath : filepaths) {
+            Check(filepath, Options{});
+        }
+
+        auto scan = ScanFile(large_objpath);
+
+        CHECK(scan.num_shapes == 20000);
+        CHECK(scan.material_library == "materials.mtl");
+        CHECK(scan.min == std::array<float, 3>{});
+        CHECK(scan.max == std::array<float, 3>{});
+    }
+
+    SUBCASE("ThreadPool")
+    {
+        auto pool    = ThreadPool(3);
+        auto options = Options{};
+
+        options.thread_pool = &pool;
+
+        Check(large_objpath, options);
+
+        auto scan = ScanFile(large_objpath, false, options);
+
+        CHECK(scan.num_shapes == 20000);
+        CHECK(scan.material_library == "materials.mtl");
+    }
+
+    SUBCASE("MemoryMap")
+    {
+        auto options = Options{};
+
+        options.read = Read::MemoryMap;
+
+        Check(large_objpath, options);
+    }
+
+    SUBCASE("Errors")
+    {
+        CHECK(ScanFile(data_dir / "missing.obj").error.code == std::errc::no_such_file_or_directory);
+        CHECK(ScanFile("").error.code == std::errc::invalid_argument);
+
+        // malformed lines are counted by their keyword, and lines without positions leave the bounds empty
+        auto objpath = std::filesystem::temp_directory_path() / "rapidobj_test_scan_errors.obj";
+
+        {
+            auto dst = std::ofstream(objpath, std::ios::binary);
+            dst << "v x y z\nvt\nvn 1\nf\nf 1 2\nxyz 1 2 3\n  g  group\n";
+        }
+
+        auto scan = ScanFile(objpath, true);
+
+        CHECK(!scan.error);
+        CHECK(scan.num_positions == 1);
+        CHECK(scan.num_texcoords == 0);
+        CHECK(scan.num_normals == 1);
+        CHECK(scan.num_faces == 1);
+        CHECK(scan.num_shapes == 1);
+        CHECK(scan.min == std::array<float, 3>{});
+        CHECK(scan.max == std::array<float, 3>{});
+
+        std::filesystem::remove(objpath);
+    }
+
+    std::filesystem::remove(large_objpath);
+}
@@ -0,0 +1,116 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <sstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::string objpath = QUOTE(TEST_DATA_DIR) "/mario/mario.obj";
+
+namespace fs = std::filesystem;
+
+static std::string ReadText(const fs::path& filepath)
+{
+    auto file = std::ifstream(filepath, std::ios::binary);
+    auto text = std::ostringstream();
+    text << file.rdbuf();
+    return text.str();
+}
+
+static size_t CountLines(std::string_view text)
+{
+    return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+}
+
+// Large enough to be split into several batches when parsed in parallel.
+static std::string LargeText()
+{
+    auto text = ReadText(objpath);
+    auto copy = text;
+    for (size_t i = 1; i != 3; ++i) {
+        text.append(copy);
+    }
+    return text;
+}
+
+TEST_CASE("rapidobj::ParseStream(large stream)")
+{
+    auto text     = LargeText();
+    auto filepath = fs::temp_directory_path() / "rapidobj_test_stream.obj";
+
+    REQUIRE(text.size() > 1024 * 1024);
+
+    {
+        auto file = std::ofstream(filepath, std::ios::binary);
+        file << text;
+    }
+
+    auto expected = ParseFile(filepath, MaterialLibrary::Ignore());
+
+    fs::remove(filepath);
+
+    REQUIRE(!expected.error);
+
+    SUBCASE("Success")
+    {
+        auto stream = std::istringstream(text);
+        auto result = ParseStream(stream, MaterialLibrary::Ignore());
+
+        CHECK(!result.error);
+        CHECK(result.attributes.positions == expected.attributes.positions);
+        CHECK(result.attributes.texcoords == expected.attributes.texcoords);
+        CHECK(result.attributes.normals == expected.attributes.normals);
+        REQUIRE(result.shapes.size() == expected.shapes.size());
+        for (size_t i = 0; i != result.shapes.size(); ++i) {
+            const auto& lhs = result.shapes[i].mesh.indices;
+            const auto& rhs = expected.shapes[i].mesh.indices;
+            CHECK(result.shapes[i].name == expected.shapes[i].name);
+            CHECK(result.shapes[i].mesh.num_face_vertices == expected.shapes[i].mesh.num_face_vertices);
+            CHECK(result.shapes[i].mesh.smoothing_group_ids == expected.shapes[i].mesh.smoothing_group_ids);
+            REQUIRE(lhs.size() == rhs.size());
+            CHECK(std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const Index& a, const Index& b) {
+                return a.position_index == b.position_index && a.texcoord_index == b.texcoord_index &&
+                       a.normal_index == b.normal_index;
+            }));
+        }
+    }
+
+    SUBCASE("ParseError")
+    {
+        auto line_num = CountLines(text) + 1;
+
+        text.append("v 1 2 x\n");
+
+        auto stream = std::istringstream(text);
+        auto result = ParseStream(stream, MaterialLibrary::Ignore());
+
+        CHECK(result.error.code == rapidobj_errc::ParseError);
+        CHECK(result.error.line == "v 1 2 x");
+        CHECK(result.error.line_num == line_num);
+    }
+
+    SUBCASE("LineTooLongError")
+    {
+        auto line_num = CountLines(text) / 2 + 1;
+        auto position = size_t{};
+
+        for (size_t i = 1; i != line_num; ++i) {
+            position = text.find('\n', position) + 1;
+        }
+
+        text.insert(position, "# " + std::string(8192, 'x') + "\n");
+
+        auto stream = std::istringstream(text);
+        auto result = ParseStream(stream, MaterialLibrary::Ignore());
+
+        CHECK(result.error.code == rapidobj_errc::LineTooLongError);
+        CHECK(result.error.line_num == line_num);
+    }
+}
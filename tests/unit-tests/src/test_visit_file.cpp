@@ -0,0 +1,248 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <deque>
+#include <fstream>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+// An index as passed to the visitor, together with the attribute counts of the chunk at the time it was visited.
+struct VisitedIndex final {
+    Index  index;
+    size_t position_count;
+    size_t texcoord_count;
+    size_t normal_count;
+};
+
+// Records the elements of one chunk.
+struct Recorder final : Visitor {
+    void Position(float x, float y, float z) override { positions.insert(positions.end(), { x, y, z }); }
+    void Texcoord(float u, float v) override { texcoords.insert(texcoords.end(), { u, v }); }
+    void Normal(float x, float y, float z) override { normals.insert(normals.end(), { x, y, z }); }
+    void Face(const Index* indices, size_t count) override { Record(indices, count, &faces); }
+    void Line(const Index* indices, size_t count) override { Record(indices, count, &lines); }
+    void Point(const Index* indices, size_t count) override { Record(indices, count, &points); }
+    void Group(std::string_view name) override { groups.emplace_back(name); }
+
+    void Record(const Index* indices, size_t count, std::vector<VisitedIndex>* out)
+    {
+        for (size_t i = 0; i != count; ++i) {
+            out->push_back({ indices[i], positions.size() / 3, texcoords.size() / 2, normals.size() / 3 });
+        }
+        if (out == &faces) {
+            face_sizes.push_back(static_cast<unsigned char>(count));
+        }
+    }
+
+    std::vector<float>         positions;
+    std::vector<float>         texcoords;
+    std::vector<float>         normals;
+    std::vector<VisitedIndex>  faces;
+    std::vector<unsigned char> face_sizes;
+    std::vector<VisitedIndex>  lines;
+    std::vector<VisitedIndex>  points;
+    std::vector<std::string>   groups;
+};
+
+// Turns the indices as written in the file into zero based indices, the way ParseFile does.
+static int Resolve(int value, size_t base, size_t count)
+{
+    if (value > 0) {
+        return value - 1;
+    }
+    if (value < 0) {
+        return static_cast<int>(base + count) + value;
+    }
+    return -1;
+}
+
+static std::vector<Index> Resolve(const std::deque<Recorder>& recorders, std::vector<VisitedIndex> Recorder::*member)
+{
+    auto result = std::vector<Index>();
+    auto bases  = std::array<size_t, 3>{};
+    for (const auto& recorder : recorders) {
+        for (const auto& [index, position_count, texcoord_count, normal_count] : recorder.*member) {
+            result.push_back({ Resolve(index.position_index, bases[0], position_count),
+                               Resolve(index.texcoord_index, bases[1], texcoord_count),
+                               Resolve(index.normal_index, bases[2], normal_count) });
+        }
+        bases[0] += recorder.positions.size() / 3;
+        bases[1] += recorder.texcoords.size() / 2;
+        bases[2] += recorder.normals.size() / 3;
+    }
+    return result;
+}
+
+template <typename T>
+static std::vector<T> Concatenate(const std::deque<Recorder>& recorders, std::vector<T> Recorder::*member)
+{
+    auto result = std::vector<T>();
+    for (const auto& recorder : recorders) {
+        result.insert(result.end(), (recorder.*member).begin(), (recorder.*member).end());
+    }
+    return result;
+}
+
+template <typename Member>
+static std::vector<Index> Concatenate(const Result& result, Member member)
+{
+    auto indices = std::vector<Index>();
+    for (const auto& shape : result.shapes) {
+        const auto& array = member(shape);
+        indices.insert(indices.end(), array.begin(), array.end());
+    }
+    return indices;
+}
+
+static bool Equal(const std::vector<Index>& lhs, const std::vector<Index>& rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Index& a, const Index& b) {
+        return a.position_index == b.position_index && a.texcoord_index == b.texcoord_index &&
+               a.normal_index == b.normal_index;
+    });
+}
+
+static void Check(const std::filesystem::path& filepath, const Options& options)
+{
+    auto recorders = std::deque<Recorder>(); // keeps the visitors in place as more are added
+    auto error     = VisitFile(
+        filepath,
+        [&recorders](size_t chunk_index) {
+            // visitors are requested in chunk order
+            CHECK(chunk_index == recorders.size());
+            return &recorders.emplace_back();
+        },
+        options);
+
+    auto expected = ParseFile(filepath, MaterialLibrary::Ignore(), options);
+
+    CHECK(error.code == expected.error.code);
+    CHECK(error.line_num == expected.error.line_num);
+
+    if (error) {
+        return;
+    }
+
+    auto face_sizes = std::vector<unsigned char>();
+    for (const auto& shape : expected.shapes) {
+        face_sizes.insert(face_sizes.end(), shape.mesh.num_face_vertices.begin(), shape.mesh.num_face_vertices.end());
+    }
+
+    auto faces  = Concatenate(expected, [](const Shape& shape) -> auto& { return shape.mesh.indices; });
+    auto lines  = Concatenate(expected, [](const Shape& shape) -> auto& { return shape.lines.indices; });
+    auto points = Concatenate(expected, [](const Shape& shape) -> auto& { return shape.points.indices; });
+
+    auto positions = Concatenate(recorders, &Recorder::positions);
+    auto texcoords = Concatenate(recorders, &Recorder::texcoords);
+    auto normals   = Concatenate(recorders, &Recorder::normals);
+
+    CHECK(std::equal(positions.begin(), positions.end(), expected.attributes.positions.begin()));
+    CHECK(std::equal(texcoords.begin(), texcoords.end(), expected.attributes.texcoords.begin()));
+    CHECK(std::equal(normals.begin(), normals.end(), expected.attributes.normals.begin()));
+    CHECK(positions.size() == expected.attributes.positions.size());
+    CHECK(texcoords.size() == expected.attributes.texcoords.size());
+    CHECK(normals.size() == expected.attributes.normals.size());
+    CHECK(Concatenate(recorders, &Recorder::face_sizes) == face_sizes);
+    CHECK(Equal(Resolve(recorders, &Recorder::faces), faces));
+    CHECK(Equal(Resolve(recorders, &Recorder::lines), lines));
+    CHECK(Equal(Resolve(recorders, &Recorder::points), points));
+}
+
+TEST_CASE("rapidobj::VisitFile")
+{
+    // a file with shapes, vertex colors and relative indices, that is large enough to be split into several chunks
+    auto large_objpath = std::filesystem::temp_directory_path() / "rapidobj_test_visit_file.obj";
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        for (size_t i = 0; i != 20000; ++i) {
+            dst << "o shape" << i % 7 << "\n";
+            dst << "v " << i << " 0 0 1 0 0\nv 0 " << i << " 0\nv 0 0 " << i << "\nvn 0 0 1\nvt 0.5 0.5\n";
+            dst << "usemtl Material" << i % 3 << "\ns " << i % 2 << "\n";
+            dst << "f -3/-1/-1 -2/-1/-1 -1/-1/-1\nf " << 3 * i + 1 << " " << 3 * i + 2 << " " << 3 * i + 3 << "\n";
+            dst << "l -1 -2\np " << 3 * i + 1 << "\n";
+        }
+    }
+
+    auto filepaths = std::vector<std::filesystem::path>{
+        data_dir / "cube" / "cube.obj",   data_dir / "mario" / "mario.obj", data_dir / "primitives" / "primitives.obj",
+        data_dir / "teapot" / "teapot.obj", data_dir / "missing.obj",      large_objpath
+    };
+
+    SUBCASE("ParseFile")
+    {
+        for (const auto& filepath : filepaths) {
+            Check(filepath, Options{});
+        }
+    }
+
+    SUBCASE("ThreadPool")
+    {
+        auto pool    = ThreadPool(3);
+        auto options = Options{};
+
+        options.thread_pool = &pool;
+
+        Check(large_objpath, options);
+    }
+
+    SUBCASE("MemoryMap")
+    {
+        auto options = Options{};
+
+        options.read = Read::MemoryMap;
+
+        Check(large_objpath, options);
+    }
+
+    SUBCASE("Elements")
+    {
+        auto objpath = std::filesystem::temp_directory_path() / "rapidobj_test_visit_elements.obj";
+
+        {
+            auto dst = std::ofstream(objpath, std::ios::binary);
+            dst << "mtllib  lib.mtl \ng  group \nv 1 2 3 0.5 0.25 0\nvt 0.5 0.75 0\nvn 0 1 0\nusemtl mat\ns off\ns 4\n";
+            dst << "f 1/1/1 -1/-1/-1 1//1\nl 1/1 -1\np 1\n";
+        }
+
+        struct Elements final : Visitor {
+            void Color(float r, float g, float b) override { color = { r, g, b }; }
+            void Face(const Index* indices, size_t count) override { face.assign(indices, indices + count); }
+            void UseMaterial(std::string_view name) override { material = name; }
+            void MaterialFile(std::string_view name) override { library = name; }
+            void SmoothingGroup(unsigned int id) override { smoothing.push_back(id); }
+            void Group(std::string_view name) override { group = name; }
+
+            std::array<float, 3>      color{};
+            std::vector<Index>        face;
+            std::string               material;
+            std::string               library;
+            std::string               group;
+            std::vector<unsigned int> smoothing;
+        } elements;
+
+        auto error = VisitFile(objpath, [&elements](size_t) { return &elements; });
+
+        CHECK(!error);
+        CHECK(elements.color == std::array<float, 3>{ 0.5f, 0.25f, 0.0f });
+        CHECK(elements.library == "lib.mtl");
+        CHECK(elements.group == "group");
+        CHECK(elements.material == "mat");
+        CHECK(elements.smoothing == std::vector<unsigned int>{ 0, 4 });
+        REQUIRE(elements.face.size() == 3);
+        CHECK(Equal(elements.face, { { 1, 1, 1 }, { -1, -1, -1 }, { 1, 0, 1 } }));
+
+        std::filesystem::remove(objpath);
+    }
+
+    std::filesystem::remove(large_objpath);
+}
@@ -0,0 +1,136 @@
+#include <doctest/doctest.h>
+#include <rapidobj/rapidobj.hpp>
+
+#include <fstream>
+#include <set>
+#include <tuple>
+
+using namespace rapidobj;
+
+#ifndef TEST_DATA_DIR
+#error Cannot find test files; TEST_DATA_DIR is not defined
+#endif
+
+#define Q(x)     #x
+#define QUOTE(x) Q(x)
+
+static const std::filesystem::path data_dir = QUOTE(TEST_DATA_DIR);
+
+static auto Tie(const Index& index)
+{
+    return std::tie(index.position_index, index.texcoord_index, index.normal_index);
+}
+
+static void Check(const Result& result, const WeldedResult& welded)
+{
+    REQUIRE(!welded.error);
+
+    auto corners = std::vector<Index>();
+    for (const auto& shape : result.shapes) {
+        corners.insert(corners.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+
+    REQUIRE(welded.indices.size() == corners.size());
+
+    // every corner keeps its indices, and vertices are numbered in order of first use
+    auto num_used = size_t{};
+    for (size_t i = 0; i != corners.size(); ++i) {
+        auto vertex = size_t{ welded.indices[i] };
+        REQUIRE(vertex <= num_used);
+        REQUIRE(vertex < welded.vertices.size());
+        CHECK(Tie(welded.vertices[vertex]) == Tie(corners[i]));
+        num_used += vertex == num_used;
+    }
+
+    CHECK(num_used == welded.vertices.size());
+
+    // no two vertices are the same
+    auto distinct = std::set<std::tuple<int, int, int>>();
+    for (const auto& vertex : welded.vertices) {
+        distinct.insert(Tie(vertex));
+    }
+
+    CHECK(distinct.size() == welded.vertices.size());
+}
+
+TEST_CASE("rapidobj::WeldVertices")
+{
+    // a file with shared and relative indices, that is large enough to be welded in several blocks
+    auto large_objpath = std::filesystem::temp_directory_path() / "rapidobj_test_weld_vertices.obj";
+
+    {
+        auto dst = std::ofstream(large_objpath, std::ios::binary);
+        for (size_t i = 0; i != 40000; ++i) {
+            if (i % 5000 == 0) {
+                dst << "o shape" << i / 5000 << "\n";
+            }
+            dst << "v " << i << " 0 0\nv 0 " << i << " 0\nv 0 0 " << i << "\nvn 0 0 1\nvt 0.5 0.5\n";
+            dst << "f -3/-1/-1 -2/-1/-1 -1/-1/-1\nf " << 3 * i + 1 << "/1 " << 3 * i + 2 << " " << 3 * i + 3 << "\n";
+            dst << "f 1/1/1 " << 3 * i + 2 << "/" << i % 13 + 1 << "/1 " << 3 * i + 3 << "/1/" << i % 7 + 1 << "\n";
+        }
+    }
+
+    auto filepaths = std::vector<std::filesystem::path>{
+        data_dir / "cube" / "cube.obj", data_dir / "mario" / "mario.obj", data_dir / "primitives" / "primitives.obj",
+        data_dir / "teapot" / "teapot.obj", large_objpath
+    };
+
+    SUBCASE("Result")
+    {
+        for (const auto& filepath : filepaths) {
+            auto result = ParseFile(filepath, MaterialLibrary::Default(Load::Optional));
+
+            REQUIRE(!result.error);
+
+            Check(result, WeldVertices(result));
+
+            REQUIRE(Triangulate(result));
+
+            Check(result, WeldVertices(result));
+        }
+    }
+
+    SUBCASE("ThreadPool")
+    {
+        auto pool     = ThreadPool(3);
+        auto parallel = Options{};
+        auto serial   = Options{};
+
+        parallel.thread_pool = &pool;
+        serial.max_threads   = 1;
+
+        auto result = ParseFile(large_objpath, MaterialLibrary::Ignore(), parallel);
+
+        REQUIRE(!result.error);
+
+        auto expected = WeldVertices(result, serial);
+        auto actual   = WeldVertices(result, parallel);
+
+        Check(result, actual);
+
+        // the result does not depend on the number of threads
+        CHECK(actual.indices == expected.indices);
+        CHECK(std::equal(
+            actual.vertices.begin(),
+            actual.vertices.end(),
+            expected.vertices.begin(),
+            expected.vertices.end(),
+            [](const Index& a, const Index& b) { return Tie(a) == Tie(b); }));
+    }
+
+    SUBCASE("Errors")
+    {
+        auto failed = ParseFile(data_dir / "missing.obj");
+
+        CHECK(WeldVertices(failed).error.code == std::errc::invalid_argument);
+
+        auto empty  = Result{};
+        auto welded = WeldVertices(empty);
+
+        CHECK(!welded.error);
+        CHECK(welded.vertices.empty());
+        CHECK(welded.indices.empty());
+    }
+
+    std::filesystem::remove(large_objpath);
+}
@@ -63,6 +63,12 @@ int Parse(int argc, char* argv[])
     options.positional_help("input-file");
 
     options.add_options()("p,parser", "Which parser to use.", value<std::string>(), "fast|rapid|tiny");
+    options.add_options()("r,read", "How rapidobj reads the file.", value<std::string>(), "standard|io_uring|mmap");
+    options.add_options()("q,queue-depth", "Reads in flight per thread (io_uring only).", value<size_t>(), "N");
+    options.add_options()("populate", "Pre-fault the file mapping (mmap only).");
+    options.add_options()("direct", "Bypass the page cache with O_DIRECT (standard and io_uring only).");
+    options.add_options()("t,threads", "Maximum number of threads used by rapidobj.", value<size_t>(), "N");
+    options.add_options()("cpus", "Pin rapidobj threads to these CPUs.", value<std::vector<size_t>>(), "N,N,...");
     options.add_options()("h,help", "Show help.");
     options.add_options()("input-file", "", value<std::string>());
 
@@ -87,6 +93,37 @@ int Parse(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    auto rapid_options = rapidobj::Options();
+
+    if (result.count("read")) {
+        const auto read = result["read"].as<std::string>();
+        if (read == "standard") {
+            rapid_options.read = rapidobj::Read::Standard;
+        } else if (read == "io_uring") {
+            rapid_options.read = rapidobj::Read::IoUring;
+        } else if (read == "mmap") {
+            rapid_options.read = rapidobj::Read::MemoryMap;
+        } else {
+            std::cout << "Error: read method not recognized (must be: standard, io_uring, or mmap)\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (result.count("queue-depth")) {
+        rapid_options.queue_depth = result["queue-depth"].as<size_t>();
+    }
+
+    rapid_options.populate  = result.count("populate") > 0;
+    rapid_options.direct_io = result.count("direct") > 0;
+
+    if (result.count("threads")) {
+        rapid_options.max_threads = result["threads"].as<size_t>();
+    }
+
+    if (result.count("cpus")) {
+        rapid_options.cpu_affinity = result["cpus"].as<std::vector<size_t>>();
+    }
+
     if (0 == result.count("input-file")) {
         std::cout << "Error: input-file missing\n";
         return EXIT_FAILURE;
@@ -126,7 +163,7 @@ int Parse(int argc, char* argv[])
     if (parser == "rapid") {
         auto t1 = std::chrono::system_clock::now();
 
-        auto rapid_result = rapidobj::ParseFile(input_filepath);
+        auto rapid_result = rapidobj::ParseFile(input_filepath, rapidobj::MaterialLibrary::Default(), rapid_options);
 
         if (rapid_result.error) {
             std::cout << rapid_result.error.code.message() << "\n";
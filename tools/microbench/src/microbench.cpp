@@ -0,0 +1,211 @@
+#include "cxxopts.hpp"
+
+#include "rapidobj/rapidobj.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+struct Lines final {
+    std::string                   text;
+    std::vector<std::string_view> views;
+};
+
+// Generates count lines with the given formatter and stores them in one contiguous buffer, like the blocks the parser
+// works on.
+template <typename Formatter>
+static Lines MakeLines(size_t count, Formatter&& format)
+{
+    auto lines   = Lines{};
+    auto offsets = std::vector<size_t>{ 0 };
+
+    for (size_t i = 0; i != count; ++i) {
+        char buffer[128];
+        format(buffer, sizeof(buffer));
+        lines.text.append(buffer).append("\n");
+        offsets.push_back(lines.text.size());
+    }
+
+    for (size_t i = 0; i != count; ++i) {
+        lines.views.emplace_back(lines.text.data() + offsets[i], offsets[i + 1] - offsets[i] - 1);
+    }
+
+    return lines;
+}
+
+// Returns the best time out of several runs, in nanoseconds per parsed value.
+template <typename Function>
+static double Measure(const Lines& lines, size_t values_per_line, size_t runs, Function&& parse)
+{
+    auto best     = Clock::duration::max();
+    auto checksum = 0.0;
+
+    for (size_t run = 0; run != runs; ++run) {
+        auto start = Clock::now();
+        for (auto line : lines.views) {
+            checksum += parse(line);
+        }
+        best = std::min(best, Clock::now() - start);
+    }
+
+    // keep the compiler from discarding the parsed values
+    if (checksum == 0.123) {
+        std::cout << checksum << '\n';
+    }
+
+    auto num_values = static_cast<double>(values_per_line * lines.views.size());
+
+    return std::chrono::duration<double, std::nano>(best).count() / num_values;
+}
+
+static void PrintRow(const std::string& name, double baseline, double rapidobj)
+{
+    char row[128];
+    auto speedup = baseline / rapidobj;
+    std::snprintf(row, sizeof(row), "%-14s %6.2f ns    %6.2f ns    %.2fx\n", name.c_str(), baseline, rapidobj, speedup);
+    std::cout << row;
+}
+
+// Vertex lines, formatted the way exporters usually write them (e.g. "-0.123456").
+static void BenchmarkReals(size_t count, size_t runs, unsigned seed)
+{
+    std::cout << "Fast reals: " << (RAPIDOBJ_FAST_REALS ? "enabled" : "disabled") << "\n\n";
+    std::cout << "Precision      fast_float   rapidobj     Speedup\n";
+
+    for (int precision : { 1, 3, 4, 6, 8, 9 }) {
+        auto engine       = std::mt19937(seed);
+        auto distribution = std::uniform_real_distribution<float>(-100.0f, 100.0f);
+
+        auto lines = MakeLines(count, [&](char* buffer, size_t size) {
+            auto x = distribution(engine);
+            auto y = distribution(engine);
+            auto z = distribution(engine);
+            std::snprintf(buffer, size, "%.*f %.*f %.*f", precision, x, precision, y, precision, z);
+        });
+
+        auto baseline = Measure(lines, 3, runs, [](std::string_view line) {
+            auto first = line.data();
+            auto last  = line.data() + line.size();
+            auto sum   = 0.0f;
+            for (size_t i = 0; i != 3 && first != last; ++i) {
+                auto value     = 0.0f;
+                auto [ptr, ec] = fast_float::from_chars(first, last, value);
+                first          = ptr + (ptr != last);
+                sum += value;
+            }
+            return sum;
+        });
+
+        auto rapidobj = Measure(lines, 3, runs, [](std::string_view line) {
+            auto first = line.data();
+            auto last  = line.data() + line.size();
+            auto sum   = 0.0f;
+            for (size_t i = 0; i != 3 && first != last; ++i) {
+                auto value     = 0.0f;
+                auto [ptr, ec] = rapidobj::detail::FromChars(first, last, value);
+                first          = ptr + (ptr != last);
+                sum += value;
+            }
+            return sum;
+        });
+
+        PrintRow(std::to_string(precision), baseline, rapidobj);
+    }
+}
+
+// Triangle lines with position/texcoord/normal indices into meshes of different sizes.
+static void BenchmarkFaces(size_t count, size_t runs, unsigned seed)
+{
+    using namespace rapidobj::detail;
+
+    // the baseline only tokenizes the indices with std::from_chars; ParseFace also resolves and validates them
+    std::cout << "\nMesh size      from_chars   rapidobj     Speedup\n";
+
+    for (int mesh_size : { 100, 10'000, 1'000'000 }) {
+        auto engine       = std::mt19937(seed);
+        auto distribution = std::uniform_int_distribution<int>(1, mesh_size);
+
+        auto lines = MakeLines(count, [&](char* buffer, size_t size) {
+            int v[9] = {};
+            for (auto& i : v) {
+                i = distribution(engine);
+            }
+            auto format = "%d/%d/%d %d/%d/%d %d/%d/%d";
+            std::snprintf(buffer, size, format, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]);
+        });
+
+        auto baseline = Measure(lines, 9, runs, [](std::string_view line) {
+            auto first = line.data();
+            auto last  = line.data() + line.size();
+            auto sum   = 0;
+            while (first != last) {
+                auto value     = 0;
+                auto [ptr, ec] = std::from_chars(first, last, value);
+                first          = ptr + (ptr != last);
+                sum += value;
+            }
+            return sum;
+        });
+
+        auto indices      = Buffer<rapidobj::Index>();
+        auto offset_flags = Buffer<OffsetFlags>();
+
+        auto rapidobj = Measure(lines, 9, runs, [&](std::string_view line) {
+            auto flags       = static_cast<OffsetFlags>(ApplyOffset::All);
+            auto [count, rc] = ParseFace(line, 0, 0, 0, 3, 3, flags, &indices, &offset_flags);
+            auto sum         = indices.back().position_index;
+            indices.pop_back();
+            indices.pop_back();
+            indices.pop_back();
+            offset_flags.pop_back();
+            offset_flags.pop_back();
+            offset_flags.pop_back();
+            return sum + static_cast<int>(count);
+        });
+
+        PrintRow(std::to_string(mesh_size), baseline, rapidobj);
+    }
+}
+
+int Run(int argc, char* argv[])
+{
+    using cxxopts::value;
+
+    auto options = cxxopts::Options(argv[0], "This tool is used to measure the speed of rapidobj's number parsing.");
+
+    options.add_options()("n,count", "Number of lines to parse.", value<size_t>()->default_value("100000"), "N");
+    options.add_options()("r,runs", "Number of runs; the best is reported.", value<size_t>()->default_value("20"), "N");
+    options.add_options()("s,seed", "Random number generator seed.", value<unsigned>()->default_value("1"), "N");
+    options.add_options()("h,help", "Show help.");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+        std::cout << options.help() << '\n';
+        return EXIT_SUCCESS;
+    }
+
+    auto count = result["count"].as<size_t>();
+    auto runs  = result["runs"].as<size_t>();
+    auto seed  = result["seed"].as<unsigned>();
+
+    BenchmarkReals(count, runs, seed);
+    BenchmarkFaces(count, runs, seed);
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    try {
+        return Run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+
+    return EXIT_FAILURE;
+}